@@ -29,23 +29,38 @@ The space complexity for storing the nodes in a Binary Search Tree (BST) is O(n)
 */
 #include <iostream>                 // For input-output operations
 #include <cmath>                    // For NAN (Not-a-Number)
+#include <vector>                   // For the sliding window's ring buffer and interval query results
+#include <utility>                  // For pair, used to return intervals
+#include <algorithm>                // For sort, inplace_merge, unique and lower_bound in bulk insertion
+#include <span>                     // For passing bulk batches
+#include <thread>                   // For parallel bulk insertion
 using namespace std;
 
 // Node structure for an AVL tree
 struct tNode {
 	tNode* left;                    // Pointer to the left child of the node
 	tNode* right;                   // Pointer to the right child of the node
-	double val;                     // Value stored in the node
+	tNode* parent;                  // Pointer to the parent of the node (nullptr for the root)
+	double val;                     // Value stored in the node (the low end when the node holds an interval)
+	double hi;                      // High end of the node's interval; equal to val for plain values
+	double maxHi;                   // Largest high end anywhere in the subtree rooted here
 	int height;                     // Integer representing the height of the node
+	int copies;                     // Number of samples with this value (always 1 outside of addSample)
+	int size;                       // Number of samples in the subtree rooted here, counting copies
+	bool dirty;                     // True if a relaxed insert passed below this node and its fields are stale
 
 	// Constructor to initialize a tree node with double
-	tNode(double b) : left(nullptr), right(nullptr), val(b), height(1) {}  // Initialize pointers and height
+	tNode(double b, double h) : left(nullptr), right(nullptr), parent(nullptr), val(b), hi(h), maxHi(h), height(1), copies(1), size(1), dirty(false) {}  // Initialize pointers and height
+	tNode(double b) : tNode(b, b) {}  // A plain value is the interval [b, b]
 };
 
 // AVL tree class definition (self-balancing binary search tree)
 class AVL {
 private:
 	tNode* head;                    // Pointer to the root node of the AVL tree
+	bool relaxed;                   // True between beginBurst and endBurst
+	int burstCt;                    // Nodes added by relaxed inserts since the last fix-up
+	bool multiset;                  // True once addSample has counted a copy; merge then adds copies instead of dropping repeats
 
 	tNode* insertRec(tNode* node, double v);    // Recursive method to insert and balance the tree
 	double retrieveRec(tNode* node, double v);  // Recursive method to retrieve a value
@@ -54,10 +69,29 @@ private:
 	tNode* rotateLeft(tNode* x);     // Method to perform a left rotation
 	tNode* balance(tNode* node);     // Method to balance the AVL tree
 	int height(tNode* node);         // Method to return the height of a node
+	int size(tNode* node);           // Method to return the subtree size of a node
+	void update(tNode* node);        // Method to recompute a node's height, size and max endpoint from its children, and relink their parents
+	void rebalanceUp(tNode* node);   // Method to update and balance every node from node up to the root
+	void insertRelaxed(double v);    // Method to insert as a plain BST, leaving the fix-up for later
+	void settle();                   // Method to run the deferred fix-up if relaxed inserts are pending
+	tNode* fixRec(tNode* node);      // Recursive method to repair dirty nodes bottom-up
+	tNode* addRec(tNode* node, double v);   // Recursive method to add a sample, counting duplicates
+	tNode* dropRec(tNode* node, double v);  // Recursive method to drop one copy of a sample
+	tNode* insertIntervalRec(tNode* node, double lo, double hi);  // Recursive method to insert an interval
+	tNode* removeIntervalRec(tNode* node, double lo, double hi);  // Recursive method to remove an interval
+	void overlapRec(tNode* node, double lo, double hi, vector<pair<double, double>>& out);  // Recursive method to collect overlapping intervals that start before lo
+	void flatten(tNode* node, vector<tNode*>& out);  // Recursive method to list a subtree's nodes in-order
+	tNode* linkRec(const vector<tNode*>& sorted, int lo, int hi);  // Recursive method to relink sorted nodes into a balanced tree
+	tNode* join(tNode* l, tNode* k, tNode* r);  // Method to join two trees around a middle node, any heights
+	tNode* buildRec(const double* first, const double* last);  // Recursive method to build a balanced tree from sorted values
+	tNode* bulkRec(tNode* node, const double* first, const double* last, int depth);  // Recursive method to insert sorted values into a subtree
 	int getBalance(tNode* node);     // Method to get the balance factor of a node
+	static bool sortsBefore(const tNode* a, const tNode* b);  // Method to compare nodes by (val, hi)
+	int validateRec(tNode* node, tNode* lo, tNode* hi);  // Recursive method to check a subtree, returns its height or -1
 	tNode* findMin(tNode* node);     // Method to find the node with the minimum value
+	tNode* detachMin(tNode* node, tNode*& min);  // Recursive method to unlink a subtree's smallest node in one descent, rebalancing on the way up
 	void deleteTree(tNode* node);    // Recursive method to delete the entire tree
-	void printHelp(tNode* node);     // Helper method for in-order printing
+	void printHelp(tNode* node);     // Helper method for in-order printing (stackless, follows parent links)
 
 public:
 	AVL();                          // Constructor to initialize the AVL tree
@@ -66,10 +100,34 @@ public:
 	double retrieve(double v);       // Method to retrieve a value
 	void remove(double v);           // Method to remove a value
 	void printInOrder();             // Method to print the tree in-order
+
+	// Multiset interface used for streaming samples; quiet and duplicate-aware
+	void addSample(double v);        // Method to add one copy of v
+	void removeSample(double v);     // Method to remove one copy of v
+	double select(int k);            // Method to return the k-th smallest sample (0-based), NAN if out of range
+	int count();                     // Method to return the number of samples held
+
+	// Interval interface; intervals are ordered by (lo, hi), so don't mix these with plain insert/remove in one tree
+	void insertInterval(double lo, double hi);  // Method to insert the interval [lo, hi]
+	void removeInterval(double lo, double hi);  // Method to remove the interval [lo, hi]
+	vector<pair<double, double>> overlapping(double lo, double hi);  // Method to return every stored interval that overlaps [lo, hi]
+
+	void merge(AVL&& other);         // Method to move every node of other into this tree in O(m + n); a shared value keeps one node, with summed copies only for sample trees
+	void insertBulk(span<const double> batch);  // Method to insert a batch of values in parallel; quiet, duplicates skipped
+	bool validate();                 // Method to check order, parent links, heights, sizes, max endpoints and balance
+
+	// Node stepping through parent links; a tNode* works as an in-order iterator
+	tNode* first();                  // Method to return the smallest node, nullptr if empty
+	static tNode* next(tNode* node); // Method to return the in-order successor, nullptr at the end (O(1) amortized)
+	void erase(tNode* node);         // Method to remove the given node in place; every other iterator stays valid
+
+	// Relaxed balance for write bursts: inserts skip height updates and rotations until endBurst
+	void beginBurst();               // Method to start deferring rebalancing
+	void endBurst();                 // Method to fix the tree up in one bottom-up pass and stop deferring
 };
 
 // Constructor for the AVL tree
-AVL::AVL() : head(nullptr) {}       // Initialize the head of the tree to nullptr
+AVL::AVL() : head(nullptr), relaxed(false), burstCt(0), multiset(false) {}       // Initialize the head of the tree to nullptr
 
 // Destructor for the AVL tree
 AVL::~AVL() {
@@ -87,7 +145,12 @@ void AVL::deleteTree(tNode* node) {
 
 // Public method to insert a value into the AVL tree
 void AVL::insert(double v) {
+	if (relaxed) {                  // In a burst, defer the balancing work
+		insertRelaxed(v);
+		return;
+	}
 	head = insertRec(head, v);      // Call the recursive insert method, starting from the root
+	if (head) head->parent = nullptr;  // The root has no parent
 }
 
 // Recursive method to insert a node into the AVL tree and balance it
@@ -108,8 +171,7 @@ tNode* AVL::insertRec(tNode* node, double v) {
 		return node;
 	}
 
-	int hl = height(node->left), hr = height(node->right);
-	node->height = 1 + (hl > hr ? hl : hr);  // Update the node's height
+	update(node);                   // Update the node's height, size and max endpoint
 	return balance(node);           // Balance the tree and return the node
 }
 
@@ -135,7 +197,9 @@ double AVL::retrieveRec(tNode* node, double v) {
 
 // Public method to remove a value
 void AVL::remove(double t) {
+	settle();                       // Finish any deferred rebalancing first
 	head = removeRec(head, t);      // Call the recursive remove method
+	if (head) head->parent = nullptr;  // The root has no parent
 }
 
 // Recursive method to remove a node and balance the tree
@@ -165,16 +229,19 @@ tNode* AVL::removeRec(tNode* node, double v) {
 			delete temp;             // Delete the temporary node
 		}
 		else {                      // If the node has two children
-			tNode* temp = findMin(node->right); // Find the in-order successor
-			node->val = temp->val;   // Replace the current node's value with the successor's
-			node->right = removeRec(node->right, temp->val); // Remove the successor
+			tNode* temp;
+			tNode* right = detachMin(node->right, temp); // Unlink the in-order successor on the way down
+			temp->left = node->left; // The successor node takes the removed node's place
+			temp->right = right;
+			cout << "Successful Remove!" << endl;
+			delete node;
+			node = temp;
 		}
 	}
 
 	if (!node) return node;         // If the tree is empty, return null
 
-	int hl = height(node->left), hr = height(node->right);
-	node->height = 1 + (hl > hr ? hl : hr);  // Update the node's height
+	update(node);                   // Update the node's height, size and max endpoint
 	return balance(node);           // Balance the tree and return the node
 }
 
@@ -186,6 +253,17 @@ tNode* AVL::findMin(tNode* node) {
 	return node;                    // Return the node with the minimum value
 }
 
+// Recursive method to unlink the smallest node of a subtree; returns the rest of the subtree, balanced
+tNode* AVL::detachMin(tNode* node, tNode*& min) {
+	if (!node->left) {              // This is the smallest node; its right subtree takes its place
+		min = node;
+		return node->right;
+	}
+	node->left = detachMin(node->left, min);
+	update(node);                   // Update the node's height, size and max endpoint
+	return balance(node);           // Balance the tree and return the node
+}
+
 // Method to perform a right rotation to balance the tree
 tNode* AVL::rotateRight(tNode* y) {
 	tNode* x = y->left;             // Set x as the left child of y
@@ -194,10 +272,8 @@ tNode* AVL::rotateRight(tNode* y) {
 	x->right = y;                   // Perform the rotation (x becomes the new root)
 	y->left = T2;                   // Move T2 to the left of y
 
-	int hl = height(y->left), hr = height(y->right);
-	y->height = (hl > hr ? hl : hr) + 1;  // Update height of y
-	hl = height(x->left), hr = height(x->right);
-	x->height = (hl > hr ? hl : hr) + 1;  // Update height of x
+	update(y);                      // Update y first, it is now x's child
+	update(x);                      // Update x
 
 	return x;                       // Return the new root
 }
@@ -210,10 +286,8 @@ tNode* AVL::rotateLeft(tNode* x) {
 	y->left = x;                    // Perform the rotation (y becomes the new root)
 	x->right = T2;                  // Move T2 to the right of x
 
-	int hl = height(y->left), hr = height(y->right);
-	y->height = (hl > hr ? hl : hr) + 1;  // Update height of y
-	hl = height(x->left), hr = height(x->right);
-	x->height = (hl > hr ? hl : hr) + 1;  // Update height of x
+	update(x);                      // Update x first, it is now y's child
+	update(y);                      // Update y
 
 	return y;                       // Return the new root
 }
@@ -251,6 +325,28 @@ int AVL::height(tNode* node) {
 	return node->height;            // Otherwise, return the height of the node
 }
 
+// Method to get the subtree size of a node
+int AVL::size(tNode* node) {
+	if (!node) return 0;            // If the node is null, return 0
+	return node->size;              // Otherwise, return the size of the subtree
+}
+
+// Method to recompute a node's augmented fields from its children
+void AVL::update(tNode* node) {
+	int hl = height(node->left), hr = height(node->right);
+	node->height = 1 + (hl > hr ? hl : hr);  // Update the node's height
+	node->size = node->copies + size(node->left) + size(node->right);  // Update the node's subtree size
+	node->maxHi = node->hi;         // Update the largest high end in the subtree
+	if (node->left) {
+		node->left->parent = node;  // Children may have just been moved under this node
+		if (node->left->maxHi > node->maxHi) node->maxHi = node->left->maxHi;
+	}
+	if (node->right) {
+		node->right->parent = node;
+		if (node->right->maxHi > node->maxHi) node->maxHi = node->right->maxHi;
+	}
+}
+
 // Method to get the balance factor of a node
 int AVL::getBalance(tNode* node) {
 	if (!node) return 0;            // If the node is null, return balance factor 0
@@ -259,15 +355,567 @@ int AVL::getBalance(tNode* node) {
 
 // Public method to print the tree in in-order traversal
 void AVL::printInOrder() {
-	printHelp(head);                // Call the recursive print helper method
+	if (head) printHelp(head);      // Call the recursive print helper method (an empty tree prints nothing)
 	cout << endl;                   // Print a new line after traversal
 }
 
 // Helper method for in-order traversal
 void AVL::printHelp(tNode* node) {
-	if (node->left) printHelp(node->left);  // Print the left subtree
-	cout << node->val << ' ';              // Print the current node's value
-	if (node->right) printHelp(node->right); // Print the right subtree
+	node = findMin(node);                  // Start at the smallest node
+	while (node) {
+		cout << node->val << ' ';          // Print the current node's value
+		node = next(node);                 // Step to the successor without a stack
+	}
+}
+
+// Public method to start a write burst
+void AVL::beginBurst() {
+	relaxed = true;
+}
+
+// Public method to end a write burst
+void AVL::endBurst() {
+	settle();
+	relaxed = false;
+}
+
+// Method to insert v as in a plain BST, then mark the path so the fix-up knows where to look
+void AVL::insertRelaxed(double v) {
+	int depth = 1;                  // Depth the new node will be at
+	tNode* up = nullptr;
+	tNode** link = &head;           // Child pointer the new node will hang from
+	while (*link) {
+		tNode* node = *link;
+		if (v == node->val) {       // If the value already exists, do nothing
+			cout << "Already present, no insert." << endl;
+			return;                 // Nothing was marked, so nothing is left for settle
+		}
+		up = node;
+		link = v < node->val ? &node->left : &node->right;
+		depth++;
+	}
+	*link = new tNode(v);
+	(*link)->parent = up;
+	for (tNode* node = up; node; node = node->parent) node->dirty = true;  // These nodes' fields will need recomputing
+	burstCt++;
+	cout << "Successful Insert!" << endl;
+
+	int n = size(head) + burstCt;   // Sizes are stale during a burst, so add what was inserted since
+	if (depth > 2 * log2(n + 1) + 2) settle();  // Path is getting too long to keep deferring
+}
+
+// Method to run the bottom-up fix-up over the dirty paths
+void AVL::settle() {
+	if (!burstCt) return;           // Nothing deferred
+	head = fixRec(head);
+	if (head) head->parent = nullptr;  // The root has no parent
+	burstCt = 0;
+}
+
+// Recursive method to repair a subtree: clean subtrees are already valid AVL trees, so only dirty paths are visited
+tNode* AVL::fixRec(tNode* node) {
+	if (!node || !node->dirty) return node;
+	node->dirty = false;
+
+	node->left = fixRec(node->left);     // Repair the children first
+	node->right = fixRec(node->right);
+	update(node);                   // Update the node's height, size and max endpoint
+
+	int balanceFactor = getBalance(node);
+	if (balanceFactor > 2 || balanceFactor < -2) {  // Too lopsided for rotations, so rebuild this subtree
+		vector<tNode*> nodes;
+		flatten(node, nodes);
+		return linkRec(nodes, 0, nodes.size());
+	}
+	return balance(node);           // A difference of 2 is fixed by the usual rotations
+}
+
+// Public method to return the smallest node
+tNode* AVL::first() {
+	return head ? findMin(head) : nullptr;
+}
+
+// Public method to step to the in-order successor
+tNode* AVL::next(tNode* node) {
+	if (node->right) {              // The successor is the leftmost node of the right subtree
+		node = node->right;
+		while (node->left) node = node->left;
+		return node;
+	}
+	while (node->parent && node == node->parent->right) {  // Otherwise climb until we come up from a left child
+		node = node->parent;
+	}
+	return node->parent;
+}
+
+// Public method to remove the node an iterator points at, without searching from the root. Values never move
+// between nodes, so only this node's iterators are invalidated.
+void AVL::erase(tNode* node) {
+	settle();                       // Finish any deferred rebalancing first
+	tNode* up = node->parent;
+	tNode* child;                   // Subtree that takes the node's place
+	tNode* from;                    // Lowest node whose height may have changed
+	if (node->left && node->right) {  // If the node has two children, move its successor node into its place
+		tNode* succ = findMin(node->right);
+		if (succ == node->right) {  // The successor is the right child: it keeps its right subtree
+			from = succ;
+		}
+		else {                      // Otherwise its right subtree takes its old place first
+			from = succ->parent;
+			from->left = succ->right;
+			if (succ->right) succ->right->parent = from;
+			succ->right = node->right;
+			succ->right->parent = succ;
+		}
+		succ->left = node->left;
+		succ->left->parent = succ;
+		child = succ;
+	}
+	else {                          // At most one child, which takes the node's place
+		child = node->left ? node->left : node->right;
+		from = up;
+	}
+
+	if (child) child->parent = up;
+	if (!up) head = child;          // Splice the node out of the tree
+	else if (up->left == node) up->left = child;
+	else up->right = child;
+	delete node;
+
+	rebalanceUp(from);              // Heights may have dropped all the way up
+}
+
+// Method to update and balance each node on the path from node to the root
+void AVL::rebalanceUp(tNode* node) {
+	while (node) {
+		tNode* up = node->parent;
+		bool wasLeft = up && up->left == node;  // Remember where node hangs before balance may replace it
+		update(node);
+		tNode* sub = balance(node);
+		sub->parent = up;
+		if (!up) head = sub;
+		else if (wasLeft) up->left = sub;
+		else up->right = sub;
+		node = up;
+	}
+}
+
+// Public method to add one copy of a sample
+void AVL::addSample(double v) {
+	settle();                       // Finish any deferred rebalancing first
+	multiset = true;                // From now on duplicates are copies
+	head = addRec(head, v);         // Call the recursive add method, starting from the root
+	if (head) head->parent = nullptr;  // The root has no parent
+}
+
+// Recursive method to add a sample, bumping the copy count of an existing value
+tNode* AVL::addRec(tNode* node, double v) {
+	if (!node) return new tNode(v); // If the node is null, create a new node
+
+	if (v < node->val) {            // If the value is less, add into the left subtree
+		node->left = addRec(node->left, v);
+	}
+	else if (v > node->val) {       // If the value is greater, add into the right subtree
+		node->right = addRec(node->right, v);
+	}
+	else {                          // If the value already exists, count another copy
+		node->copies++;
+		node->size++;
+		return node;
+	}
+
+	update(node);                   // Update the node's height, size and max endpoint
+	return balance(node);           // Balance the tree and return the node
+}
+
+// Public method to remove one copy of a sample
+void AVL::removeSample(double v) {
+	settle();                       // Finish any deferred rebalancing first
+	head = dropRec(head, v);        // Call the recursive drop method, starting from the root
+	if (head) head->parent = nullptr;  // The root has no parent
+}
+
+// Recursive method to drop one copy of a sample, removing the node with its last copy
+tNode* AVL::dropRec(tNode* node, double v) {
+	if (!node) return nullptr;      // Not present, nothing to drop
+
+	if (v < node->val) {            // If the value is less, search the left subtree
+		node->left = dropRec(node->left, v);
+	}
+	else if (v > node->val) {       // If the value is greater, search the right subtree
+		node->right = dropRec(node->right, v);
+	}
+	else if (node->copies > 1) {    // Other copies remain, so only the counts change
+		node->copies--;
+		node->size--;
+		return node;
+	}
+	else if (!node->left || !node->right) { // If the node has one or no children
+		tNode* temp = node->left ? node->left : node->right; // The child that takes its place
+		delete node;
+		return temp;
+	}
+	else {                          // If the node has two children
+		tNode* temp;
+		tNode* right = detachMin(node->right, temp); // Unlink the in-order successor, copies and all
+		temp->left = node->left;    // The successor node takes this node's place
+		temp->right = right;
+		delete node;
+		node = temp;
+	}
+
+	update(node);                   // Update the node's height, size and max endpoint
+	return balance(node);           // Balance the tree and return the node
+}
+
+// Public method to return the k-th smallest sample using the subtree sizes
+double AVL::select(int k) {
+	settle();                       // Finish any deferred rebalancing first
+	if (k < 0 || k >= size(head)) return NAN;  // Out of range
+	tNode* node = head;
+	while (true) {
+		int ls = size(node->left); // Samples smaller than this node's value
+		if (k < ls) {              // The answer is in the left subtree
+			node = node->left;
+		}
+		else if (k < ls + node->copies) {  // The answer is this node's value
+			return node->val;
+		}
+		else {                     // The answer is in the right subtree
+			k -= ls + node->copies;
+			node = node->right;
+		}
+	}
+}
+
+// Public method to return the number of samples held
+int AVL::count() {
+	settle();                       // Finish any deferred rebalancing first
+	return size(head);
+}
+
+// Public method to insert the interval [lo, hi]
+void AVL::insertInterval(double lo, double hi) {
+	settle();                       // Finish any deferred rebalancing first
+	head = insertIntervalRec(head, lo, hi);  // Call the recursive insert method, starting from the root
+	if (head) head->parent = nullptr;  // The root has no parent
+}
+
+// Recursive method to insert an interval, ordered by low end then high end
+tNode* AVL::insertIntervalRec(tNode* node, double lo, double hi) {
+	if (!node) return new tNode(lo, hi);  // If the node is null, create a new node
+
+	if (lo < node->val || (lo == node->val && hi < node->hi)) {  // If the interval sorts before, insert into the left subtree
+		node->left = insertIntervalRec(node->left, lo, hi);
+	}
+	else if (lo > node->val || hi > node->hi) {  // If the interval sorts after, insert into the right subtree
+		node->right = insertIntervalRec(node->right, lo, hi);
+	}
+	else {                          // If the interval already exists, do nothing
+		return node;
+	}
+
+	update(node);                   // Update the node's height, size and max endpoint
+	return balance(node);           // Balance the tree and return the node
+}
+
+// Public method to remove the interval [lo, hi]
+void AVL::removeInterval(double lo, double hi) {
+	settle();                       // Finish any deferred rebalancing first
+	head = removeIntervalRec(head, lo, hi);  // Call the recursive remove method, starting from the root
+	if (head) head->parent = nullptr;  // The root has no parent
+}
+
+// Recursive method to remove an interval and balance the tree
+tNode* AVL::removeIntervalRec(tNode* node, double lo, double hi) {
+	if (!node) return nullptr;      // Not present, nothing to remove
+
+	if (lo < node->val || (lo == node->val && hi < node->hi)) {  // If the interval sorts before, search the left subtree
+		node->left = removeIntervalRec(node->left, lo, hi);
+	}
+	else if (lo > node->val || hi > node->hi) {  // If the interval sorts after, search the right subtree
+		node->right = removeIntervalRec(node->right, lo, hi);
+	}
+	else if (!node->left || !node->right) { // If the node has one or no children
+		tNode* temp = node->left ? node->left : node->right; // The child that takes its place
+		delete node;
+		return temp;
+	}
+	else {                          // If the node has two children
+		tNode* temp;
+		tNode* right = detachMin(node->right, temp); // Unlink the in-order successor
+		temp->left = node->left;    // The successor node takes this node's place
+		temp->right = right;
+		delete node;
+		node = temp;
+	}
+
+	update(node);                   // Update the node's height, size and max endpoint
+	return balance(node);           // Balance the tree and return the node
+}
+
+// Public method to return every interval overlapping [lo, hi], in two sorted runs. Intervals starting inside
+// [lo, hi] all overlap, so one descent finds the first and an in-order walk reports the rest: O(log n + k).
+// Intervals starting before lo overlap only if they reach lo; the maxHi descent for those enters just the
+// subtrees holding one, so it costs O(log n) plus the paths down to the ones it reports.
+vector<pair<double, double>> AVL::overlapping(double lo, double hi) {
+	settle();                       // Finish any deferred rebalancing first
+	vector<pair<double, double>> out;  // Overlapping intervals in sorted order
+	overlapRec(head, lo, hi, out);  // Those starting before lo
+
+	tNode* from = nullptr;          // First interval starting at or after lo
+	for (tNode* node = head; node; ) {
+		if (node->val >= lo) {
+			from = node;
+			node = node->left;
+		}
+		else node = node->right;
+	}
+	for (tNode* node = from; node && node->val <= hi; node = next(node)) {
+		out.push_back({ node->val, node->hi });  // Starts inside [lo, hi], so it overlaps
+	}
+	return out;
+}
+
+// Recursive method to collect the intervals starting before lo that reach it, pruning subtrees that end too early
+void AVL::overlapRec(tNode* node, double lo, double hi, vector<pair<double, double>>& out) {
+	if (!node || node->maxHi < lo) return;  // Nothing in this subtree ends late enough
+
+	overlapRec(node->left, lo, hi, out);    // Check the left subtree
+	if (node->val >= lo || node->val > hi) return;  // This node and everything right of it are the walk's, or start too late
+	if (node->hi >= lo) out.push_back({ node->val, node->hi });  // This node overlaps
+	overlapRec(node->right, lo, hi, out);   // Check the right subtree
+}
+
+// Public method to merge other into this tree, leaving other empty
+void AVL::merge(AVL&& other) {
+	settle();                       // Finish any deferred rebalancing first
+	other.settle();
+	if (&other == this || !other.head) return;  // Nothing to merge
+
+	vector<tNode*> a, b;            // Both trees' nodes in sorted order
+	flatten(head, a);
+	flatten(other.head, b);
+	other.head = nullptr;           // The nodes now belong to this tree
+
+	vector<tNode*> merged;          // Both lists merged into one sorted list
+	merged.reserve(a.size() + b.size());
+	size_t i = 0, j = 0;
+	while (i < a.size() && j < b.size()) {
+		tNode* x = a[i];
+		tNode* y = b[j];
+		if (x->val < y->val || (x->val == y->val && x->hi < y->hi)) {  // x sorts first
+			merged.push_back(x);
+			i++;
+		}
+		else if (y->val < x->val || y->hi < x->hi) {  // y sorts first
+			merged.push_back(y);
+			j++;
+		}
+		else {                      // Same value in both trees: keep one node, with both copy counts if either tree counts copies
+			if (multiset || other.multiset) x->copies += y->copies;
+			delete y;
+			merged.push_back(x);
+			i++;
+			j++;
+		}
+	}
+	while (i < a.size()) merged.push_back(a[i++]);  // Whatever is left of either list is already sorted
+	while (j < b.size()) merged.push_back(b[j++]);
+
+	head = linkRec(merged, 0, merged.size());  // Rebuild a balanced tree from the same nodes
+	if (head) head->parent = nullptr;  // The root has no parent
+	multiset = multiset || other.multiset;
+}
+
+// Recursive method to list a subtree's nodes in-order
+void AVL::flatten(tNode* node, vector<tNode*>& out) {
+	if (!node) return;
+	flatten(node->left, out);       // Nodes of the left subtree come first
+	out.push_back(node);
+	flatten(node->right, out);      // Then the right subtree
+}
+
+// Recursive method to relink the sorted nodes [lo, hi) into a balanced tree
+tNode* AVL::linkRec(const vector<tNode*>& sorted, int lo, int hi) {
+	if (lo >= hi) return nullptr;   // Empty range gives an empty subtree
+
+	int mid = lo + (hi - lo) / 2;   // Middle node becomes the root of this subtree
+	tNode* node = sorted[mid];
+	node->left = linkRec(sorted, lo, mid);       // Link the left half
+	node->right = linkRec(sorted, mid + 1, hi);  // Link the right half
+
+	update(node);                   // Update the node's height, size and max endpoint
+	return node;
+}
+
+// Batches below this size are handled by one thread
+const ptrdiff_t PARALLEL_CUTOFF = 4096;
+
+// Sorts v[lo, hi), splitting the work across threads for the first depth levels
+void parallelSort(vector<double>& v, size_t lo, size_t hi, int depth) {
+	if (depth <= 0 || (ptrdiff_t)(hi - lo) < PARALLEL_CUTOFF) {  // Small or deep enough: sort here
+		sort(v.begin() + lo, v.begin() + hi);
+		return;
+	}
+	size_t mid = lo + (hi - lo) / 2;
+	thread left(parallelSort, ref(v), lo, mid, depth - 1);  // Sort the left half on another thread
+	parallelSort(v, mid, hi, depth - 1);                    // Sort the right half on this one
+	left.join();
+	inplace_merge(v.begin() + lo, v.begin() + mid, v.begin() + hi);  // Merge the sorted halves
+}
+
+// Public method to insert a batch of values into the tree
+void AVL::insertBulk(span<const double> batch) {
+	settle();                       // Finish any deferred rebalancing first
+	if (batch.empty()) return;
+
+	int depth = 0;                  // Levels of the recursion that may spawn a thread
+	for (unsigned n = thread::hardware_concurrency(); n > 1; n /= 2) depth++;
+
+	vector<double> sorted(batch.begin(), batch.end());
+	parallelSort(sorted, 0, sorted.size(), depth);
+	sorted.erase(unique(sorted.begin(), sorted.end()), sorted.end());  // Drop duplicates within the batch
+
+	head = bulkRec(head, sorted.data(), sorted.data() + sorted.size(), depth);
+	if (head) head->parent = nullptr;  // The root has no parent
+}
+
+// Recursive method to insert the sorted values [first, last) into the subtree rooted at node.
+// The values are split around node, each side goes into its own subtree (in parallel near the top),
+// and join puts the possibly very different sized results back together balanced.
+tNode* AVL::bulkRec(tNode* node, const double* first, const double* last, int depth) {
+	if (first == last) return node;                 // Nothing to insert here
+	if (!node) return buildRec(first, last);        // Empty subtree: build it straight from the values
+
+	const double* mid = lower_bound(first, last, node->val);  // First value not less than the node's
+	const double* rightStart = (mid != last && *mid == node->val) ? mid + 1 : mid;  // Skip a value already in the tree
+
+	tNode* l = node->left;
+	tNode* r = node->right;
+	if (depth > 0 && last - first >= PARALLEL_CUTOFF) {  // Big enough to split across threads
+		thread worker([&] { l = bulkRec(l, first, mid, depth - 1); });  // Left side on another thread
+		r = bulkRec(r, rightStart, last, depth - 1);                    // Right side on this one
+		worker.join();
+	}
+	else {
+		l = bulkRec(l, first, mid, 0);
+		r = bulkRec(r, rightStart, last, 0);
+	}
+	return join(l, node, r);        // Reattach the node between its grown subtrees
+}
+
+// Recursive method to build a balanced tree from the sorted values [first, last)
+tNode* AVL::buildRec(const double* first, const double* last) {
+	if (first == last) return nullptr;  // Empty range gives an empty subtree
+
+	const double* mid = first + (last - first) / 2;  // Middle value becomes the root of this subtree
+	tNode* node = new tNode(*mid);
+	node->left = buildRec(first, mid);       // Build the left half
+	node->right = buildRec(mid + 1, last);   // Build the right half
+
+	update(node);                   // Update the node's height, size and max endpoint
+	return node;
+}
+
+// Method to join trees l and r (all of l < k < all of r) under k, whatever their heights
+tNode* AVL::join(tNode* l, tNode* k, tNode* r) {
+	if (height(l) > height(r) + 1) {  // l is much taller: walk down its right spine
+		l->right = join(l->right, k, r);
+		update(l);
+		return balance(l);
+	}
+	if (height(r) > height(l) + 1) {  // r is much taller: walk down its left spine
+		r->left = join(l, k, r->left);
+		update(r);
+		return balance(r);
+	}
+	k->left = l;                      // Heights are close enough for k to sit on top
+	k->right = r;
+	update(k);
+	return k;
+}
+
+// Public method to check every invariant of the tree
+bool AVL::validate() {
+	settle();                       // Finish any deferred rebalancing first
+	return !head || (!head->parent && validateRec(head, nullptr, nullptr) >= 0);
+}
+
+// Method to compare two nodes in tree order: by value, then by high end
+bool AVL::sortsBefore(const tNode* a, const tNode* b) {
+	return a->val < b->val || (a->val == b->val && a->hi < b->hi);
+}
+
+// Recursive method to check a subtree whose nodes must all sort between lo and hi (nullptr for no bound)
+int AVL::validateRec(tNode* node, tNode* lo, tNode* hi) {
+	if (!node) return 0;            // An empty subtree is valid with height 0
+	if (node->dirty || node->copies < 1) return -1;  // Pending fix-up or a node with no samples
+	if ((lo && !sortsBefore(lo, node)) || (hi && !sortsBefore(node, hi))) return -1;  // Out of order
+	if ((node->left && node->left->parent != node) || (node->right && node->right->parent != node)) return -1;  // Broken parent link
+
+	int hl = validateRec(node->left, lo, node);   // Check the left subtree
+	int hr = validateRec(node->right, node, hi);  // Check the right subtree
+	if (hl < 0 || hr < 0 || hl - hr > 1 || hr - hl > 1) return -1;  // Bad subtree or out of balance
+
+	double maxHi = node->hi;        // Recompute the augmented fields and compare
+	if (node->left && node->left->maxHi > maxHi) maxHi = node->left->maxHi;
+	if (node->right && node->right->maxHi > maxHi) maxHi = node->right->maxHi;
+	int h = 1 + (hl > hr ? hl : hr);
+	if (node->height != h || node->size != node->copies + size(node->left) + size(node->right) || node->maxHi != maxHi) return -1;
+	return h;
+}
+
+// Fixed-size sliding window over a stream of samples that answers quantile queries.
+// The ring buffer remembers arrival order so the oldest sample can be evicted; the AVL keeps them sorted.
+class slidingWindow {
+private:
+	AVL tree;                       // Samples currently in the window, sorted
+	vector<double> ring;            // Samples in arrival order
+	size_t next;                    // Ring position the next sample goes to
+	size_t filled;                  // Number of samples in the window
+
+public:
+	slidingWindow(size_t n);        // Constructor for a window of the last n samples
+	void push(double v);            // Method to add a sample, evicting the oldest when full
+	double quantile(double q);      // Method to return the q-quantile (0 <= q <= 1), NAN if empty
+	double median();                // Method to return the median
+};
+
+// Constructor for the sliding window
+slidingWindow::slidingWindow(size_t n) : ring(n ? n : 1), next(0), filled(0) {}
+
+// Public method to add a sample in O(log n)
+void slidingWindow::push(double v) {
+	if (filled == ring.size()) {    // Window is full, so the oldest sample leaves
+		tree.removeSample(ring[next]);
+	}
+	else {
+		filled++;
+	}
+	tree.addSample(v);
+	ring[next] = v;                 // Overwrite the oldest slot
+	next = (next + 1) % ring.size();
+}
+
+// Public method to return the q-quantile (nearest rank, rounded down) in O(log n)
+double slidingWindow::quantile(double q) {
+	if (!filled) return NAN;        // No samples yet
+	if (q < 0) q = 0;
+	if (q > 1) q = 1;
+	return tree.select((int)(q * (filled - 1)));
+}
+
+// Public method to return the median
+double slidingWindow::median() {
+	return quantile(0.5);
+}
+
+// Prints one check result and counts it if it failed
+bool check(const char* what, bool ok, int& failures) {
+	cout << (ok ? "ok   " : "FAIL ") << what << endl;
+	if (!ok) failures++;
+	return ok;
 }
 
 int main() {
@@ -310,5 +958,125 @@ int main() {
 
 	tree.printInOrder();             // Print the updated tree in-order
 
-	return 0;                        // End the program
+	int failures = 0;                // Checks below that did not hold
+	cout << endl << "CHECKS:" << endl;
+
+	// Median of the last 5 samples as they stream in; 3 arrives twice
+	slidingWindow window(5);
+	vector<double> medians;
+	cout << "Sliding medians:";
+	for (double v : { 5, 1, 9, 3, 7, 3, 8 }) {
+		window.push(v);
+		medians.push_back(window.median());
+		cout << ' ' << medians.back();
+	}
+	cout << endl;
+	check("slidingWindow median evicts the oldest sample", medians == vector<double>{ 5, 1, 5, 3, 5, 3, 7 }, failures);
+	check("slidingWindow quantile ends", window.quantile(0) == 3 && window.quantile(1) == 9, failures);
+	AVL samples;                     // Repeated samples are counted, not rejected
+	for (double v : { 4, 2, 4, 8, 2, 4 }) samples.addSample(v);
+	samples.removeSample(4);
+	check("addSample/removeSample count copies", samples.count() == 5 && samples.select(2) == 4 && samples.select(4) == 8 && samples.validate(), failures);
+
+	// Overlap queries on a small set of intervals, then against a brute-force scan of a larger one
+	AVL intervals;
+	for (pair<double, double> iv : { make_pair(15, 20), make_pair(10, 30), make_pair(17, 19), make_pair(5, 20), make_pair(12, 15), make_pair(30, 40) }) {
+		intervals.insertInterval(iv.first, iv.second);
+	}
+	vector<pair<double, double>> hits = intervals.overlapping(14, 16);
+	cout << "Intervals overlapping [14, 16]:";
+	for (const pair<double, double>& iv : hits) cout << " [" << iv.first << ", " << iv.second << "]";
+	cout << endl;
+	check("overlapping finds every interval in order", hits == vector<pair<double, double>>{ {5, 20}, {10, 30}, {12, 15}, {15, 20} }, failures);
+	intervals.removeInterval(10, 30);
+	check("removeInterval drops it from later queries", intervals.overlapping(25, 35) == vector<pair<double, double>>{ {30, 40} } && intervals.validate(), failures);
+
+	AVL many;
+	vector<pair<double, double>> all;  // The same intervals in a plain list
+	for (int i = 0; i < 300; i++) {
+		double lo = i * 37 % 1000, hi = lo + i * 13 % 50;  // Distinct low ends
+		many.insertInterval(lo, hi);
+		all.push_back({ lo, hi });
+	}
+	sort(all.begin(), all.end());
+	bool scanned = true;             // Wide, narrow, single-point, empty and past-the-end windows
+	for (pair<double, double> q : { make_pair(400, 450), make_pair(0, 1000), make_pair(512, 513), make_pair(37, 37), make_pair(300, 200), make_pair(1100, 1200) }) {
+		vector<pair<double, double>> expected;
+		for (const pair<double, double>& iv : all) {
+			if (iv.first <= q.second && iv.second >= q.first) expected.push_back(iv);
+		}
+		scanned = scanned && many.overlapping(q.first, q.second) == expected;
+	}
+	check("overlapping matches a full scan", scanned && many.validate(), failures);
+
+	// Merge two sample trees that share a value; the source ends up empty
+	AVL odds, evens;
+	for (double v : { 1, 3, 5, 7, 9 }) odds.addSample(v);
+	for (double v : { 2, 4, 6, 5 }) evens.addSample(v);
+	odds.merge(std::move(evens));
+	cout << "Merged: ";
+	odds.printInOrder();
+	check("merge keeps every sample and empties the source", odds.count() == 9 && evens.count() == 0 && odds.select(4) == 5 && odds.select(5) == 5 && odds.select(6) == 6, failures);
+	check("merge leaves a valid AVL tree", odds.validate(), failures);
+
+	// Merging two sets keeps one copy of a shared value
+	AVL left, right;
+	for (double v : { 1, 2 }) left.insert(v);
+	for (double v : { 2, 3 }) right.insert(v);
+	left.merge(std::move(right));
+	left.remove(2);
+	check("merge of two sets keeps each value once", left.count() == 2 && left.select(0) == 1 && left.select(1) == 3 && left.validate(), failures);
+
+	// Bulk insert a batch with repeats into a tree that already has values, large enough to use the parallel path
+	AVL bulk;
+	vector<double> batch;
+	for (int i = 0; i < 20000; i++) batch.push_back(i * 7 % 10007);  // Every value below 10007, most of them twice
+	bulk.insertBulk(span<const double>(batch.data(), 100));  // A first, small batch
+	bulk.insertBulk(batch);
+	cout << "Bulk inserted " << batch.size() << " values, " << bulk.count() << " distinct" << endl;
+	check("insertBulk keeps each value once", bulk.count() == 10007 && bulk.select(0) == 0 && bulk.select(5000) == 5000 && bulk.select(10006) == 10006, failures);
+	check("insertBulk leaves a valid AVL tree", bulk.validate(), failures);
+
+	// Walk the bulk tree through parent links, then erase every multiple of 3 in place during a second walk
+	int walked = 0;
+	bool ordered = true;
+	for (tNode* n = bulk.first(); n; n = AVL::next(n)) {
+		ordered = ordered && n->val == walked;
+		walked++;
+	}
+	check("first/next visit every node in order", walked == 10007 && ordered, failures);
+	for (tNode* n = bulk.first(); n; ) {
+		if ((int)n->val % 3) {
+			n = AVL::next(n);
+			continue;
+		}
+		tNode* after = AVL::next(n);
+		bulk.erase(n);
+		n = after;
+	}
+	cout << "Erased multiples of 3 while walking, " << bulk.count() << " left" << endl;
+	check("erase(tNode*) removes only the nodes it is given", bulk.count() == 6671 && bulk.select(0) == 1 && bulk.select(1) == 2 && bulk.select(2) == 4 && bulk.select(6670) == 10006, failures);
+	check("erase(tNode*) leaves a valid AVL tree", bulk.validate(), failures);
+	tNode* root = bulk.first();     // Climb to the root, which has two children
+	while (root->parent) root = root->parent;
+	tNode* succ = AVL::next(root);
+	double succVal = succ->val;
+	bulk.erase(root);
+	check("erase(tNode*) of a node with two children keeps its successor's iterator", succ->val == succVal && bulk.count() == 6670 && bulk.validate(), failures);
+
+	// Sorted inserts in a write burst, the worst case for deferred balancing; lookups still work mid-burst
+	AVL burst;
+	burst.beginBurst();
+	for (int i = 1; i <= 16; i++) burst.insert(i);
+	burst.insert(8);                 // Already present
+	bool foundMid = burst.retrieve(16) == 16;
+	burst.endBurst();
+	check("burst inserts are found before endBurst", foundMid, failures);
+	check("endBurst leaves every value in a valid AVL tree", burst.count() == 16 && burst.select(0) == 1 && burst.select(15) == 16 && burst.validate(), failures);
+	burst.beginBurst();
+	burst.insert(4);                 // A burst holding only a duplicate
+	burst.endBurst();
+	check("a burst of duplicates leaves the tree valid", burst.count() == 16 && burst.validate(), failures);
+
+	return failures ? 1 : 0;         // End the program, failing if any check did
 }
@@ -18,6 +18,27 @@ Separate chaining resolves collisions by using an AVL tree in each bucket to sto
 #include <random>      // Include random library
 #include <fstream>     // Include file handling library
 #include <limits>      // Include limits library for numeric limits
+#include <algorithm>   // Include algorithm library for sorting batches
+#include <concepts>    // Include concepts library for the bucket contract
+#include <memory>      // Include memory library for shared bucket ownership
+#include <atomic>      // Include atomic library for the lock-free skip list
+#include <chrono>      // Include chrono library for the bucket benchmarks
+#include <cstdint>     // Include fixed-width integers for compact node indices
+#include <type_traits> // Include type traits for picking the index type
+#include <bit>         // Include bit library for counting compare-mask bits
+#include <unordered_map> // Include unordered map for the heavy-hitter counters
+#include <map>         // Include ordered map for the LSM bucket's memtable
+#include <thread>      // Include thread library for the parallel duplicate-number join
+#include <functional>  // Include functional library for passing join phases to threads
+#include <optional>    // Include optional library for keeping a copy of an inserted person
+#include <cstdio>      // Include C I/O for the page file
+#include <cstring>     // Include C string functions for fixed-size disk records
+#include <mutex>       // Include mutex library for the LSM bucket's background compactor
+#if defined(__AVX2__)
+#include <immintrin.h> // Include AVX2 intrinsics for the packed phone-number search and sketch merges
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h> // Include SSE2 intrinsics for sketch merges
+#endif
 using namespace std;   // Use the standard namespace
 
 // Structure to store person details
@@ -41,9 +62,10 @@ struct tNode {
 	tNode* right;       // Pointer to the right child of the node
 	person val;         // Value stored in the node (person object)
 	int height;         // Integer representing the height of the node
+	bool dead;          // True if the node was removed in lazy-delete mode and awaits compaction
 
 	// Constructor to initialize a tree node with a person object
-	tNode(person p) : left(nullptr), right(nullptr), val(p), height(1) {}  // Initialize pointers and height
+	tNode(person p) : left(nullptr), right(nullptr), val(p), height(1), dead(false) {}  // Initialize pointers and height
 };
 
 // AVL tree class definition (self-balancing binary search tree)
@@ -51,7 +73,12 @@ class AVL {
 private:
 	tNode* head;        // Pointer to the root node of the AVL tree
 
-	tNode* insertRec(tNode* node, const person& v);    // Recursive method to insert and balance the tree
+	int count;          // Number of live nodes in the tree
+	int deadCt;         // Number of dead nodes still linked into the tree
+	bool lazy;          // True if removals only mark nodes dead
+	double maxDead;     // Fraction of dead nodes that triggers compaction
+
+	tNode* insertRec(tNode* node, person& v);          // Recursive method to insert and balance the tree
 	person retrieveRec(tNode* node, const string& v);  // Recursive method to retrieve a person
 	tNode* removeRec(tNode* node, const string& v);    // Recursive method to remove and balance the tree
 	tNode* removeRecFL(tNode* node, const string& fn, const string& ln); // Remove by first and last name
@@ -62,21 +89,58 @@ private:
 	int getBalance(tNode* node);     // Method to get the balance factor of a node
 	tNode* findMin(tNode* node);     // Method to find the node with the minimum value
 	void deleteTree(tNode* node);    // Recursive method to delete the entire tree
+	tNode* copyTree(tNode* node);    // Recursive method to deep-copy a subtree
 	void printHelp(tNode* node, const string& first_name = " ");     // Helper method for in-order printing
+	tNode* buildRec(const vector<person>& sorted, int lo, int hi);   // Recursive method to build a balanced tree from a sorted range
+	tNode* linkRec(const vector<tNode*>& sorted, int lo, int hi);    // Recursive method to relink sorted nodes into a balanced tree
+	bool markDead(const string& v);  // Method to mark the node with number v dead, true if one was found
+	void markDeadFL(tNode* node, const string& fn, const string& ln); // Recursive method to mark every node with a name dead
+	void compactIfNeeded();          // Method to compact once the dead fraction passes maxDead
 
 public:
 	AVL();          // Constructor to initialize the AVL tree
+	AVL(const AVL& other);        // Copy constructor (deep copy)
+	AVL(AVL&& other) noexcept;    // Move constructor
+	AVL& operator=(AVL other);    // Copy/move assignment
 	~AVL();         // Destructor to clean up the AVL tree
-	void insert(const person& v);           // Method to insert a value into the AVL tree
+	bool insert(person v);                  // Method to insert a value into the AVL tree, true if it was added
+	int insertBatch(vector<person> batch);  // Method to insert many values at once, returns how many were added
 	person retrieve(const string& v);       // Method to retrieve a value by number
 	void remove(const string& v);           // Method to remove a value by number
+	bool erase(const person& p);            // Method to remove the value with p's number, true if it was removed
+	int size() const;                       // Method to return the number of nodes
+	template <typename F> void forEach(F&& visit) const;  // Method to call visit on every value in-order
+	template <typename F> int page(string& after, int n, F&& visit);  // Method to visit up to n values numbered after `after` ("" = from the start), moving `after` to the last one
 	void removeFL(const string& fn, const string& ln);  // Method to remove a value by first and last name
 	void printAll();        // Method to print the tree in-order
 	void printFN(const string& first_name); // Method to print based on first name
+	void setLazyDelete(bool on, double threshold = 0.25);  // Method to switch lazy deletion on or off
+	bool lazyDelete() const;  // Method to tell whether removals only mark nodes dead
+	void compact();         // Method to unlink dead nodes and rebuild a balanced tree in linear time
 };
 
 // Constructor for the AVL tree
-AVL::AVL() : head(nullptr) {}   // Initialize the head of the tree to nullptr
+AVL::AVL() : head(nullptr), count(0), deadCt(0), lazy(false), maxDead(0.25) {}   // Initialize the head of the tree to nullptr
+
+// Copy constructor for the AVL tree
+AVL::AVL(const AVL& other) : head(copyTree(other.head)), count(other.count), deadCt(other.deadCt), lazy(other.lazy), maxDead(other.maxDead) {}
+
+// Move constructor for the AVL tree
+AVL::AVL(AVL&& other) noexcept : head(other.head), count(other.count), deadCt(other.deadCt), lazy(other.lazy), maxDead(other.maxDead) {
+	other.head = nullptr;   // Leave the source as an empty tree
+	other.count = 0;
+	other.deadCt = 0;
+}
+
+// Assignment operator for the AVL tree (copy-and-swap)
+AVL& AVL::operator=(AVL other) {
+	swap(head, other.head);
+	swap(count, other.count);
+	swap(deadCt, other.deadCt);
+	swap(lazy, other.lazy);
+	swap(maxDead, other.maxDead);
+	return *this;           // other now owns and frees the old nodes
+}
 
 // Destructor for the AVL tree
 AVL::~AVL() {
@@ -92,15 +156,30 @@ void AVL::deleteTree(tNode* node) {
 	}
 }
 
+// Recursive method to deep-copy a subtree
+tNode* AVL::copyTree(tNode* node) {
+	if (!node) return nullptr;      // Copy of an empty subtree is empty
+
+	tNode* copy = new tNode(node->val);   // Copy the current node
+	copy->height = node->height;
+	copy->dead = node->dead;
+	copy->left = copyTree(node->left);     // Copy the left subtree
+	copy->right = copyTree(node->right);   // Copy the right subtree
+	return copy;
+}
+
 // Public method to insert a value into the AVL tree
-void AVL::insert(const person& v) {
+bool AVL::insert(person v) {
+	int before = count;          // Remember the size to see if a node was added
 	head = insertRec(head, v);  // Call the recursive insert method, starting from the root
+	return count > before;
 }
 
 // Recursive method to insert a node into the AVL tree and balance it
-tNode* AVL::insertRec(tNode* node, const person& v) {
+tNode* AVL::insertRec(tNode* node, person& v) {
 	if (!node) {
-		return new tNode(v); // If the node is null, create a new node
+		count++;
+		return new tNode(std::move(v)); // If the node is null, create a new node
 	}
 
 	if (v.number < node->val.number) {    // If the value is less, insert into the left subtree
@@ -109,6 +188,13 @@ tNode* AVL::insertRec(tNode* node, const person& v) {
 	else if (v.number > node->val.number) { // If the value is greater, insert into the right subtree
 		node->right = insertRec(node->right, v);
 	}
+	else if (node->dead) {    // If the value belongs to a dead node, bring the node back
+		node->val = std::move(v);
+		node->dead = false;
+		deadCt--;
+		count++;
+		return node;
+	}
 	else {    // If the value already exists, do nothing
 		cout << "Already present, no insert." << endl;
 		return node;
@@ -119,6 +205,41 @@ tNode* AVL::insertRec(tNode* node, const person& v) {
 	return balance(node);   // Balance the tree and return the node
 }
 
+// Public method to insert a batch of values into the AVL tree
+int AVL::insertBatch(vector<person> batch) {
+	int before = count;  // Remember the size to report how many were added
+	sort(batch.begin(), batch.end(), [](const person& a, const person& b) { return a.number < b.number; });  // Sort the batch by number
+
+	if (head) {    // If the tree already has nodes, insert in sorted order
+		for (person& p : batch) head = insertRec(head, p);
+		return count - before;
+	}
+
+	vector<person> unique;  // Batch with duplicate numbers removed
+	unique.reserve(batch.size());
+	for (person& p : batch) {
+		if (!unique.empty() && unique.back().number == p.number) cout << "Already present, no insert." << endl;
+		else unique.push_back(std::move(p));
+	}
+	head = buildRec(unique, 0, unique.size());  // Build a balanced tree directly, no rotations needed
+	count = unique.size();
+	return count - before;
+}
+
+// Recursive method to build a balanced tree from the sorted range [lo, hi)
+tNode* AVL::buildRec(const vector<person>& sorted, int lo, int hi) {
+	if (lo >= hi) return nullptr;  // Empty range gives an empty subtree
+
+	int mid = lo + (hi - lo) / 2;  // Middle element becomes the root of this subtree
+	tNode* node = new tNode(sorted[mid]);
+	node->left = buildRec(sorted, lo, mid);       // Build the left half
+	node->right = buildRec(sorted, mid + 1, hi);  // Build the right half
+
+	int hl = height(node->left), hr = height(node->right);
+	node->height = 1 + (hl > hr ? hl : hr);  // Update the node's height
+	return node;
+}
+
 // Public method to retrieve a value by number
 person AVL::retrieve(const string& t) {
 	return retrieveRec(head, t);   // Call the recursive retrieve method
@@ -128,6 +249,7 @@ person AVL::retrieve(const string& t) {
 person AVL::retrieveRec(tNode* node, const string& v) {
 	if (!node) return person();  // If the node is null, return an empty person
 	if (v == node->val.number) {  // If the value matches, return it
+		if (node->dead) return person();  // Dead nodes are treated as absent
 		return node->val;
 	}
 	else if (v < node->val.number) {  // If the value is less, search the left subtree
@@ -140,9 +262,109 @@ person AVL::retrieveRec(tNode* node, const string& v) {
 
 // Public method to remove a value by number
 void AVL::remove(const string& t) {
+	if (lazy) {    // In lazy mode only mark the node dead
+		if (!markDead(t)) cout << "Node not found!" << endl;
+		return;
+	}
 	head = removeRec(head, t);  // Call the recursive remove method
 }
 
+// Public method to remove the value with p's number
+bool AVL::erase(const person& p) {
+	int before = count;          // Remember the size to see if a node was removed
+	remove(p.number);
+	return count < before;
+}
+
+// Method to mark the node with number v dead without restructuring the tree
+bool AVL::markDead(const string& v) {
+	tNode* node = head;
+	while (node && v != node->val.number) {  // Search down the tree for the number
+		node = v < node->val.number ? node->left : node->right;
+	}
+	if (!node || node->dead) return false;  // Not present (or already removed)
+
+	node->dead = true;
+	count--;
+	deadCt++;
+	compactIfNeeded();
+	return true;
+}
+
+// Recursive method to mark every live node with the given name dead
+void AVL::markDeadFL(tNode* node, const string& fn, const string& ln) {
+	if (!node) return;
+
+	markDeadFL(node->left, fn, ln);    // Mark in the left subtree
+	if (!node->dead && fn == node->val.first_name && ln == node->val.last_name) {
+		node->dead = true;
+		count--;
+		deadCt++;
+	}
+	markDeadFL(node->right, fn, ln);   // Mark in the right subtree
+}
+
+// Public method to switch lazy deletion on or off
+void AVL::setLazyDelete(bool on, double threshold) {
+	lazy = on;
+	maxDead = threshold;
+	if (!lazy) compact();    // Leaving lazy mode must not leave dead nodes behind
+}
+
+// Public method to tell whether lazy deletion is on
+bool AVL::lazyDelete() const {
+	return lazy;
+}
+
+// Method to compact once the dead fraction passes maxDead
+void AVL::compactIfNeeded() {
+	if (deadCt > maxDead * (count + deadCt)) compact();
+}
+
+// Public method to unlink dead nodes and rebuild a balanced tree from the live ones
+void AVL::compact() {
+	if (!deadCt) return;     // Nothing to reclaim
+
+	vector<tNode*> live;     // Live nodes in sorted order
+	live.reserve(count);
+	vector<tNode*> stack;    // Nodes whose left side has been walked but which are not yet visited
+	tNode* node = head;
+	while (node || !stack.empty()) {
+		while (node) {       // Walk down to the leftmost unvisited node
+			stack.push_back(node);
+			node = node->left;
+		}
+		node = stack.back();
+		stack.pop_back();
+		tNode* next = node->right;
+		if (node->dead) delete node;   // Free dead nodes as they are passed
+		else live.push_back(node);
+		node = next;
+	}
+
+	head = linkRec(live, 0, live.size());  // Reuse the live nodes, no reallocation
+	deadCt = 0;
+}
+
+// Recursive method to relink the sorted nodes [lo, hi) into a balanced tree
+tNode* AVL::linkRec(const vector<tNode*>& sorted, int lo, int hi) {
+	if (lo >= hi) return nullptr;  // Empty range gives an empty subtree
+
+	int mid = lo + (hi - lo) / 2;  // Middle node becomes the root of this subtree
+	tNode* node = sorted[mid];
+	node->left = linkRec(sorted, lo, mid);       // Link the left half
+	node->right = linkRec(sorted, mid + 1, hi);  // Link the right half
+
+	int hl = height(node->left), hr = height(node->right);
+	node->height = 1 + (hl > hr ? hl : hr);  // Update the node's height
+	return node;
+}
+
+// Public method to return the number of nodes
+int AVL::size() const {
+	return count;
+}
+
 // Recursive method to remove a node and balance the tree
 tNode* AVL::removeRec(tNode* node, const string& v) {
 	if (!node) {
@@ -167,6 +389,7 @@ tNode* AVL::removeRec(tNode* node, const string& v) {
 				*node = *temp;   // Copy the non-null child to the current node
 			}
 			delete temp;   // Delete the temporary node
+			count--;
 		}
 		else {    // If the node has two children
 			tNode* temp = findMin(node->right); // Find the in-order successor
@@ -183,6 +406,11 @@ tNode* AVL::removeRec(tNode* node, const string& v) {
 }
 
 void AVL::removeFL(const string& fn, const string& ln) {
+	if (lazy) {    // In lazy mode mark the whole burst dead and compact at most once
+		markDeadFL(head, fn, ln);
+		compactIfNeeded();
+		return;
+	}
 	head = removeRecFL(head, fn, ln);  // Call the recursive remove by first and last name
 }
 
@@ -203,6 +431,7 @@ tNode* AVL::removeRecFL(tNode* node, const string& fn, const string& ln) {
 				*node = *temp;       // Copy the non-null child to the current node
 			}
 			delete temp;             // Delete the temporary node
+			count--;
 		}
 		else {                      // If the node has two children
 			tNode* temp = findMin(node->right); // Find the in-order successor
@@ -306,180 +535,4250 @@ void AVL::printFN(const string& first_name) {
 	if (head) printHelp(head, first_name);
 }
 
+// Public method to visit every value in-order
+template <typename F>
+void AVL::forEach(F&& visit) const {
+	vector<tNode*> stack;  // Nodes whose left side has been walked but which are not yet visited
+	tNode* node = head;
+	while (node || !stack.empty()) {
+		while (node) {     // Walk down to the leftmost unvisited node
+			stack.push_back(node);
+			node = node->left;
+		}
+		node = stack.back();
+		stack.pop_back();
+		if (!node->dead) visit(node->val);  // Visit the current node's value
+		node = node->right;
+	}
+}
+
+// Public method to visit the next page of values in-order. Only the path to the resume point is walked, so a page
+// costs O(log n + k) for k values however deep into the tree it starts, and values inserted or removed between pages are handled.
+template <typename F>
+int AVL::page(string& after, int n, F&& visit) {
+	vector<tNode*> stack;  // Nodes after the resume point whose left side is already accounted for
+	for (tNode* node = head; node; ) {  // Seek the first value numbered after `after`
+		if (after.empty() || node->val.number > after) {
+			stack.push_back(node);
+			node = node->left;
+		}
+		else node = node->right;
+	}
+
+	int visited = 0;  // Values visited on this page
+	while (visited < n && !stack.empty()) {
+		tNode* node = stack.back();
+		stack.pop_back();
+		if (!node->dead) {
+			visit(node->val);  // Visit the current node's value
+			after = node->val.number;
+			visited++;
+		}
+		for (node = node->right; node; node = node->left) stack.push_back(node);  // Leftmost path of the right subtree comes next
+	}
+	return visited;
+}
+
 // Helper method for in-order traversal
 void AVL::printHelp(tNode* node, const string& first_name) {
 	if (node->left) printHelp(node->left, first_name);  // Print the left subtree
-	if (first_name == " " || first_name == node->val.first_name) cout << node->val.first_name << ' ' << node->val.last_name << " : " << node->val.number << " || ";              // Print the current node's value
+	if (!node->dead && (first_name == " " || first_name == node->val.first_name)) cout << node->val.first_name << ' ' << node->val.last_name << " : " << node->val.number << " || ";              // Print the current node's value
 	if (node->right) printHelp(node->right, first_name); // Print the right subtree
 }
 
 //-----------------------------------------------------------------------------------------------------------------------------------------------------------------
-//Hash Table
+// Treap: randomized alternative to the AVL with the same bucket interface, balanced by split/join instead of rotations
 
-// Function to generate a list of small prime numbers up to a limit
-std::vector<int>* generate_small_primes(int limit) {
-	std::vector<int>* primes = new vector<int>;  // Dynamically allocate a vector of integers
-	primes->push_back(2);          // Add 2 as the first prime number
+// Node structure for a treap
+struct trNode {
+	trNode* left;       // Pointer to the left child of the node
+	trNode* right;      // Pointer to the right child of the node
+	person val;         // Value stored in the node (person object)
+	unsigned priority;  // Random heap priority; a parent's priority is never below its children's
 
-	for (int i = 3; i <= limit; i += 2) {  // Check only odd numbers
-		bool is_prime = true;      // Assume the number is prime
-		for (int prime : *primes) { // Check divisibility by smaller primes
-			if (prime * prime > i) break; // Stop if the prime exceeds the square root of the number
-			if (i % prime == 0) {  // If divisible, it's not a prime
-				is_prime = false;
-				break;
-			}
-		}
-		if (is_prime) {            // If still prime, add it to the list
-			primes->push_back(i);
-		}
+	// Constructor to initialize a treap node with a person object and priority
+	trNode(person p, unsigned pr) : left(nullptr), right(nullptr), val(std::move(p)), priority(pr) {}
+};
+
+// Treap class definition (keyed by number like the AVL)
+class treap {
+private:
+	trNode* head;       // Pointer to the root node of the treap
+	int count;          // Number of nodes in the treap
+	mt19937 rng;        // Source of node priorities
+
+	void split(trNode* node, const string& key, trNode*& l, trNode*& r);  // Method to split into numbers < key and >= key
+	trNode* join(trNode* l, trNode* r);  // Method to join two treaps where every number in l is less than every number in r
+	trNode* removeRec(trNode* node, const string& v);  // Recursive method to remove a number
+	trNode* copyTree(trNode* node);      // Recursive method to deep-copy a subtree
+	void deleteTree(trNode* node);       // Recursive method to delete the entire treap
+	void printHelp(trNode* node, const string& first_name = " ");  // Helper method for in-order printing
+
+public:
+	treap();                             // Constructor to initialize the treap
+	treap(const treap& other);           // Copy constructor (deep copy)
+	treap(treap&& other) noexcept;       // Move constructor
+	treap& operator=(treap other);       // Copy/move assignment
+	~treap();                            // Destructor to clean up the treap
+	bool insert(person v);               // Method to insert a value, true if it was added
+	person retrieve(const string& v);    // Method to retrieve a value by number
+	void remove(const string& v);        // Method to remove a value by number
+	bool erase(const person& p);         // Method to remove the value with p's number, true if it was removed
+	void removeFL(const string& fn, const string& ln);  // Method to remove every value with a first and last name
+	int size() const;                    // Method to return the number of nodes
+	template <typename F> void forEach(F&& visit);  // Method to call visit on every value in-order
+	void printAll();                     // Method to print the treap in-order
+	void printFN(const string& first_name);  // Method to print based on first name
+};
+
+// Constructor for the treap
+treap::treap() : head(nullptr), count(0), rng(random_device{}()) {}
+
+// Copy constructor for the treap
+treap::treap(const treap& other) : head(copyTree(other.head)), count(other.count), rng(other.rng) {}
+
+// Move constructor for the treap
+treap::treap(treap&& other) noexcept : head(other.head), count(other.count), rng(other.rng) {
+	other.head = nullptr;   // Leave the source as an empty treap
+	other.count = 0;
+}
+
+// Assignment operator for the treap (copy-and-swap)
+treap& treap::operator=(treap other) {
+	swap(head, other.head);
+	swap(count, other.count);
+	swap(rng, other.rng);
+	return *this;           // other now owns and frees the old nodes
+}
+
+// Destructor for the treap
+treap::~treap() {
+	deleteTree(head);
+}
+
+// Recursive method to delete the entire treap
+void treap::deleteTree(trNode* node) {
+	if (node) {
+		deleteTree(node->left);
+		deleteTree(node->right);
+		delete node;
 	}
-	return primes;                 // Return the list of primes
 }
 
-// Helper function to check if a number is prime using a list of smaller prime numbers
-//Will not work properly if not all primes < sqrt(num) are on primes list
-bool is_prime(int num, const std::vector<int>* primes) {
-	if (num <= 1) return false;    // Numbers less than or equal to 1 are not prime
-	if (num == 2) return true;     // 2 is prime
-	if (num % 2 == 0) return false; // Even numbers greater than 2 are not prime
+// Recursive method to deep-copy a subtree
+trNode* treap::copyTree(trNode* node) {
+	if (!node) return nullptr;
+	trNode* copy = new trNode(node->val, node->priority);
+	copy->left = copyTree(node->left);
+	copy->right = copyTree(node->right);
+	return copy;
+}
 
-	// Check divisibility by smaller primes up to sqrt(num)
-	int limit = std::sqrt(num);    // Calculate the square root of the number
-	for (int prime : *primes) {    // Iterate through the list of smaller primes
-		if (prime > limit) break;  // If the prime exceeds the limit, stop
-		if (num % prime == 0) {    // If the number is divisible by any prime, it's not prime
-			return false;
-		}
+// Method to split node's subtree into l (numbers < key) and r (numbers >= key)
+void treap::split(trNode* node, const string& key, trNode*& l, trNode*& r) {
+	if (!node) {
+		l = r = nullptr;
+		return;
+	}
+	if (node->val.number < key) {   // The node and its left subtree go left
+		split(node->right, key, node->right, r);
+		l = node;
+	}
+	else {                          // The node and its right subtree go right
+		split(node->left, key, l, node->left);
+		r = node;
 	}
-	return true;                   // Return true if no divisor was found (prime number)
 }
 
-// Function to find the next prime number greater than or equal to `n`
-int next_prime(int n) {
-	if (n <= 2) return 2;          // Return 2 if the input is less than or equal to 2
+// Method to join l and r, keeping the higher priority on top
+trNode* treap::join(trNode* l, trNode* r) {
+	if (!l) return r;
+	if (!r) return l;
+	if (l->priority > r->priority) {
+		l->right = join(l->right, r);
+		return l;
+	}
+	r->left = join(l, r->left);
+	return r;
+}
 
-	if (n % 2 == 0) n++;           // If the number is even, start with the next odd number
+// Public method to insert a value into the treap
+bool treap::insert(person v) {
+	trNode* node = head;
+	while (node && node->val.number != v.number) {  // Check whether the number is already present
+		node = v.number < node->val.number ? node->left : node->right;
+	}
+	if (node) {
+		cout << "Already present, no insert." << endl;
+		return false;
+	}
 
-	vector<int>* small_primes = generate_small_primes(std::sqrt(n) + 1); // Pre-generate small primes
+	trNode* l;
+	trNode* r;
+	split(head, v.number, l, r);    // Cut the treap where the new number goes
+	head = join(join(l, new trNode(std::move(v), rng())), r);  // And glue it back with the new node in between
+	count++;
+	return true;
+}
 
-	while (!is_prime(n, small_primes)) { // Check if the current number is prime
-		n += 2;                  // Increment by 2 to skip even numbers
+// Public method to retrieve a value by number
+person treap::retrieve(const string& v) {
+	trNode* node = head;
+	while (node) {
+		if (v == node->val.number) return node->val;
+		node = v < node->val.number ? node->left : node->right;
 	}
+	return person();                // Not found, return an empty person
+}
 
-	delete small_primes;           // Free the memory used by the small primes vector
+// Public method to remove a value by number
+void treap::remove(const string& v) {
+	head = removeRec(head, v);
+}
 
-	return n;                      // Return the next prime number
+// Recursive method to remove a number; the removed node's children are joined in its place
+trNode* treap::removeRec(trNode* node, const string& v) {
+	if (!node) {
+		cout << "Node not found!" << endl;
+		return nullptr;
+	}
+	if (v < node->val.number) {
+		node->left = removeRec(node->left, v);
+	}
+	else if (v > node->val.number) {
+		node->right = removeRec(node->right, v);
+	}
+	else {
+		trNode* rest = join(node->left, node->right);
+		delete node;
+		count--;
+		return rest;
+	}
+	return node;
 }
 
-template <typename cldManage>
-class hashTable {  // Template class definition for hashTable with a type parameter cldManage
-public:
-	hashTable(int expElementCT = 6);  // Constructor declaration with a default argument
-	~hashTable();  // Destructor declaration
+// Public method to remove the value with p's number
+bool treap::erase(const person& p) {
+	int before = count;
+	remove(p.number);
+	return count < before;
+}
+
+// Public method to remove every value with the given first and last name
+void treap::removeFL(const string& fn, const string& ln) {
+	vector<string> numbers;         // Numbers to remove, gathered first so the walk is not disturbed
+	forEach([&](const person& p) { if (p.first_name == fn && p.last_name == ln) numbers.push_back(p.number); });
+	for (const string& n : numbers) remove(n);
+}
 
-	// Deleberately has no insert/remove because the key for cldManage may be different than for this hash table.
-	cldManage& retrieve(string key);  // Method to retrieve an element based on its key
+// Public method to return the number of nodes
+int treap::size() const {
+	return count;
+}
 
-	void printAll();  // Method to print all elements; not typical for hash tables
-	void printFN(string first_name);  // Method to print elements based on the first name
+// Public method to visit every value in-order
+template <typename F>
+void treap::forEach(F&& visit) {
+	vector<trNode*> stack;          // Nodes whose left side has been walked but which are not yet visited
+	trNode* node = head;
+	while (node || !stack.empty()) {
+		while (node) {
+			stack.push_back(node);
+			node = node->left;
+		}
+		node = stack.back();
+		stack.pop_back();
+		visit(node->val);
+		node = node->right;
+	}
+}
+
+// Public method to print the treap in-order
+void treap::printAll() {
+	if (head) printHelp(head);
+}
+
+void treap::printFN(const string& first_name) {
+	if (head) printHelp(head, first_name);
+}
+
+// Helper method for in-order traversal
+void treap::printHelp(trNode* node, const string& first_name) {
+	if (node->left) printHelp(node->left, first_name);
+	if (first_name == " " || first_name == node->val.first_name) cout << node->val.first_name << ' ' << node->val.last_name << " : " << node->val.number << " || ";
+	if (node->right) printHelp(node->right, first_name);
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Lock-free skip list: alternative bucket that many threads may read and write at once without locks.
+// Removal marks a node's links (low pointer bit) and any traversal snips marked nodes out with CAS.
+// A removed node may still be in use by a concurrent reader, so it is freed by epochs: each operation announces the
+// list's epoch while inside, the epoch only moves on once every operation inside has seen it, and a node retired in
+// epoch e is freed once the epoch reaches e + 2. Nobody ever waits for anybody; a busy list keeps advancing epochs,
+// so each thread holds at most a few batches of retired nodes however long the load lasts.
+
+const int SKIP_LEVELS = 16;         // Maximum number of levels (plenty for 2^16 numbers per bucket)
+
+// Node structure for a skip list
+struct slNode {
+	person val;                     // Value stored in the node (person object)
+	int top;                        // Highest level the node is linked on
+	atomic<uintptr_t> next[SKIP_LEVELS];  // Successor at each level; the low bit set means this node is removed at that level
+	atomic<int> owners;             // Parties still able to link it: its inserter and its place in the list; the last one to let go retires it
+	slNode* retiredNext;            // Next node in a retired batch
+
+	// Constructor to initialize a skip list node with a person object and height
+	slNode(person p, int t) : val(std::move(p)), top(t), owners(2), retiredNext(nullptr) {
+		for (atomic<uintptr_t>& n : next) n.store(0, memory_order_relaxed);
+	}
+};
+
+// Skip list class definition (keyed by number like the AVL)
+class skipList {
 private:
-	cldManage* table;  // Pointer to the array of cldManage elements (the hash table)
-	int len;  // Length of the hash table
+	static const int EPOCH_BAGS = 3;     // Retired batches per thread: this epoch's, and the two that may still be read
+	static const int ADVANCE_EVERY = 32; // Retirements by one thread between attempts to move the epoch on
 
-	unsigned long long hash(string key);  // Method to compute the hash value for a given key
+	// Epoch state of one thread while it is inside the list; records are reused, and freed with the list
+	struct epochRecord {
+		atomic<bool> taken{ false };     // Held by a thread inside the list
+		atomic<uint64_t> state{ 0 };     // 2 * epoch + 1 while its holder is inside, 0 otherwise
+		slNode* bag[EPOCH_BAGS] = {};    // Nodes retired by its holders, by epoch modulo EPOCH_BAGS
+		uint64_t bagEpoch[EPOCH_BAGS] = {};  // Epoch each bag was filled in
+		int sinceAdvance = 0;            // Retirements since the last attempt to advance
+		epochRecord* next = nullptr;     // Next record of the list
+	};
+
+	// Announces a thread inside the list for as long as it lives
+	class opGuard {
+	public:
+		opGuard(skipList& l);       // Constructor; takes a record and announces the current epoch
+		~opGuard();                 // Destructor; leaves, moves the epoch on now and then, and frees what is safe
+		epochRecord& rec;           // Record held while inside
+	private:
+		skipList& list;             // List being used
+	};
+
+	slNode* head;                   // Sentinel before the first node, linked on every level
+	atomic<int> count;              // Number of live nodes
+	atomic<uint64_t> epoch;         // Global epoch
+	atomic<epochRecord*> records;   // Every record made so far
+	atomic<int> retiredCt;          // Nodes retired and not yet freed
+
+	static slNode* ptr(uintptr_t link) { return (slNode*)(link & ~(uintptr_t)1); }  // Pointer part of a link
+	static bool marked(uintptr_t link) { return link & 1; }  // Mark part of a link
+	static int randomLevel();       // Method to pick a node height (geometric, p = 1/2)
+	bool find(const string& key, slNode** preds, slNode** succs);  // Method to locate key, snipping removed nodes on the way
+	void purge(const string& key);  // Method to snip every removed node numbered key off every level
+	void release(slNode* node, epochRecord& rec);  // Method to let go of a node, retiring it if nobody else can link it
+	void retire(slNode* node, epochRecord& rec);  // Method to put an unlinked node in the record's bag for this epoch
+	epochRecord& acquire();         // Method to take a free record, making one if all are held
+	bool tryAdvance();              // Method to move the epoch on if every thread inside has seen it
+	int freeSafe(epochRecord& rec); // Method to free the record's bags that nobody can still read, returns how many nodes
+	void append(const person& p, slNode** last);  // Method to add p after every node in last (single-threaded builds only)
+
+public:
+	skipList();                     // Constructor to initialize the skip list
+	skipList(const skipList& other);  // Copy constructor (deep copy, not safe against concurrent writers of other)
+	skipList(skipList&& other) noexcept;  // Move constructor; the source is left empty and may only be destroyed or assigned
+	skipList& operator=(skipList other);  // Copy/move assignment
+	~skipList();                    // Destructor to clean up the skip list
+	bool insert(person v);          // Method to insert a value, true if it was added (quiet, so threads can share it)
+	person retrieve(const string& v);  // Method to retrieve a value by number, without locks or waiting
+	void remove(const string& v);   // Method to remove a value by number
+	bool erase(const person& p);    // Method to remove the value with p's number, true if this call removed it
+	void removeFL(const string& fn, const string& ln);  // Method to remove every value with a first and last name
+	int size() const;               // Method to return the number of live nodes
+	int retiredCount() const;       // Method to return the number of removed nodes not yet freed
+	template <typename F> void forEach(F&& visit);  // Method to call visit on every live value in order
+	int reclaim();                  // Method to free every retired node no thread can still reach, returns how many were freed
+	void printAll();                // Method to print the skip list in order
+	void printFN(const string& first_name);  // Method to print based on first name
 };
 
-// Constructor definition for the hash table
-template <typename cldManage>
-hashTable<cldManage>::hashTable(int expElementCt) {  // Constructor implementation
-	// Set tableLen to the next prime greater than expected number of books divided by 0.75
-	len = next_prime(expElementCt / 0.75 + 1);  // Calculate and assign the length of the hash table
-	table = new cldManage[len];  // Dynamically allocate an array of cldManage elements for the hash table
+// Constructor for the skip list
+skipList::skipList() : head(new slNode(person(), SKIP_LEVELS - 1)), count(0), epoch(0), records(nullptr), retiredCt(0) {}
+
+// Copy constructor for the skip list
+skipList::skipList(const skipList& other) : skipList() {
+	slNode* last[SKIP_LEVELS];      // Last node on each level so far
+	for (slNode*& l : last) l = head;
+	for (slNode* node = ptr(other.head->next[0].load()); node; node = ptr(node->next[0].load())) {
+		if (!marked(node->next[0].load())) append(node->val, last);  // Copy live nodes in order
+	}
 }
 
-template <typename cldManage>
-hashTable<cldManage>::~hashTable() {  // Destructor implementation
-	delete[] table;  // Deallocate the memory used by the table
+// Move constructor for the skip list
+skipList::skipList(skipList&& other) noexcept : head(other.head), count(other.count.load()), epoch(other.epoch.load()),
+	records(other.records.exchange(nullptr)), retiredCt(other.retiredCt.exchange(0)) {
+	other.head = nullptr;           // The source no longer owns any nodes
+	other.count.store(0);
 }
 
-template <typename cldManage>
-cldManage& hashTable<cldManage>::retrieve(string key) {  // Method to retrieve an element by key
-	return table[hash(key) % len];  // Return the element at the hashed index
+// Assignment operator for the skip list (copy-and-swap)
+skipList& skipList::operator=(skipList other) {
+	swap(head, other.head);
+	other.count.store(count.exchange(other.count.load()));
+	other.epoch.store(epoch.exchange(other.epoch.load()));
+	other.records.store(records.exchange(other.records.load()));  // Retired nodes travel with their records
+	other.retiredCt.store(retiredCt.exchange(other.retiredCt.load()));
+	return *this;                   // other now owns and frees the old nodes
 }
 
-template <typename cldManage>
-void hashTable<cldManage>::printAll() {  // Method to print all elements in the hash table
-	for (int i = 0; i < len; i++) {  // Loop through each index of the table
-		table[i].printAll();  // Call printAll on each cldManage element
+// Destructor for the skip list
+skipList::~skipList() {
+	slNode* node = head;
+	while (node) {                  // Free everything still on level 0, live or marked
+		slNode* next = ptr(node->next[0].load());
+		delete node;
+		node = next;
+	}
+	epochRecord* rec = records.load();
+	while (rec) {                   // Free every retired node, then the records
+		for (slNode* n : rec->bag) {
+			while (n) {
+				slNode* next = n->retiredNext;
+				delete n;
+				n = next;
+			}
+		}
+		epochRecord* next = rec->next;
+		delete rec;
+		rec = next;
 	}
 }
 
-template <typename cldManage>
-void hashTable<cldManage>::printFN(string first_name) {  // Method to print elements by first name
-	for (int i = 0; i < len; i++) {  // Loop through each index of the table
-		table[i].printFN(first_name);  // Call printFN on each cldManage element with the provided first name
+// Constructor for the guard: announce the epoch, and announce again if it moved on meanwhile, so that once inside
+// the epoch can advance at most once more before this thread leaves
+skipList::opGuard::opGuard(skipList& l) : rec(l.acquire()), list(l) {
+	uint64_t e = list.epoch.load();
+	while (true) {
+		rec.state.store(2 * e + 1);
+		uint64_t now = list.epoch.load();
+		if (now == e) break;
+		e = now;
 	}
 }
 
-template <typename cldManage>
-unsigned long long hashTable<cldManage>::hash(string key) {  // Method to compute a hash value for a given key
-	const unsigned long long fnv_prime = 1099511628211ULL;  // FNV prime number constant
-	unsigned long long hash = 14695981039346656037ULL;  // FNV offset basis
+// Destructor for the guard: leave, try to move the epoch on after a batch of retirements, and free old bags
+skipList::opGuard::~opGuard() {
+	rec.state.store(0);
+	if (rec.sinceAdvance >= ADVANCE_EVERY && list.tryAdvance()) rec.sinceAdvance = 0;  // On failure, try again on the way out next time
+	list.freeSafe(rec);
+	rec.taken.store(false);
+}
 
-	for (char c : key) {  // Loop through each character in the key
-		hash ^= c;  // XOR the character with the hash
-		hash *= fnv_prime;  // Multiply the hash by the FNV prime
+// Private method to take a free record; records are only ever added, so a scan never meets a freed one
+skipList::epochRecord& skipList::acquire() {
+	for (epochRecord* r = records.load(); r; r = r->next) {
+		bool held = false;
+		if (!r->taken.load() && r->taken.compare_exchange_strong(held, true)) return *r;
 	}
+	epochRecord* r = new epochRecord();  // Every record is held: add one
+	r->taken.store(true);
+	r->next = records.load();
+	while (!records.compare_exchange_weak(r->next, r)) {}
+	return *r;
+}
 
-	return hash;  // Return the computed hash value
+// Private method to move the epoch on; fails if a thread inside still announces an older one
+bool skipList::tryAdvance() {
+	uint64_t e = epoch.load();
+	for (epochRecord* r = records.load(); r; r = r->next) {
+		uint64_t s = r->state.load();
+		if (s && s != 2 * e + 1) return false;
+	}
+	return epoch.compare_exchange_strong(e, e + 1);
 }
 
-int main() {  // Entry point of the program
-	ifstream file("Lab3_Problem2_DSC++.csv");  // Open the CSV file for reading
+// Private method to free the bags filled at least two epochs ago: every thread that could have reached their nodes
+// has left since
+int skipList::freeSafe(epochRecord& rec) {
+	uint64_t e = epoch.load();
+	int freed = 0;
+	for (int i = 0; i < EPOCH_BAGS; i++) {
+		if (!rec.bag[i] || rec.bagEpoch[i] + 2 > e) continue;
+		for (slNode* n = rec.bag[i]; n; ) {
+			slNode* next = n->retiredNext;
+			delete n;
+			n = next;
+			freed++;
+		}
+		rec.bag[i] = nullptr;
+	}
+	retiredCt -= freed;
+	return freed;
+}
 
-	// Check if the file is open
-	if (!file.is_open()) {  // Check if the file failed to open
-		cerr << "Error: Could not open the file!" << std::endl;  // Output error message to standard error
-		return 1;  // Exit the program with an error code
+// Public method to free every retired node no thread can still reach. Moving the epoch on twice makes every bag old
+// enough when nobody else is inside; records held by other threads are left to them.
+int skipList::reclaim() {
+	tryAdvance();
+	tryAdvance();
+	int freed = 0;
+	for (epochRecord* r = records.load(); r; r = r->next) {
+		bool held = false;
+		if (r->taken.load() || !r->taken.compare_exchange_strong(held, true)) continue;
+		freed += freeSafe(*r);
+		r->taken.store(false);
 	}
+	return freed;
+}
 
-	hashTable<hashTable<AVL>> table(11);  // Create a hash table with a size of 11
-	string first_name;  // Variable to store the first name
-	string last_name;  // Variable to store the last name
-	string number;  // Variable to store the number
-	person temp;  // Temporary person object
+// Method to pick a random node height
+int skipList::randomLevel() {
+	thread_local mt19937 rng(random_device{}());  // One generator per thread, no sharing
+	unsigned bits = rng();
+	int level = 0;
+	while ((bits & 1) && level < SKIP_LEVELS - 1) {
+		level++;
+		bits >>= 1;
+	}
+	return level;
+}
 
-	// Read each line from the file
-	while (file.peek() != EOF) {  // Continue until the end of the file is reached
-		file.ignore(numeric_limits<streamsize>::max(), '\'');  // Ignore characters until the first single quote
-		if (!(file >> first_name)) break;  // Read the first name, break if reading fails
+// Method to add p at the end of the list, used when copying from an already sorted list
+void skipList::append(const person& p, slNode** last) {
+	slNode* node = new slNode(p, randomLevel());
+	node->owners.store(1);          // Linked in full already
+	for (int l = 0; l <= node->top; l++) {
+		last[l]->next[l].store((uintptr_t)node);
+		last[l] = node;
+	}
+	count++;
+}
 
-		file.ignore(numeric_limits<streamsize>::max(), ' ');  // Ignore the space after the first name
-		if (!getline(file, last_name, '\'')) break;  // Read the last name until the next single quote, break if reading fails
+// Method to fill preds/succs with the last node before key and the first node at or after it on each level.
+// Marked nodes met on the way are snipped out; if a snip fails another thread changed pred, so start over.
+bool skipList::find(const string& key, slNode** preds, slNode** succs) {
+retry:
+	slNode* pred = head;
+	slNode* curr = nullptr;
+	for (int l = SKIP_LEVELS - 1; l >= 0; l--) {
+		curr = ptr(pred->next[l].load());
+		while (curr) {
+			uintptr_t succ = curr->next[l].load();
+			if (marked(succ)) {     // curr is being removed, unlink it at this level
+				uintptr_t expected = (uintptr_t)curr;
+				if (!pred->next[l].compare_exchange_strong(expected, (uintptr_t)ptr(succ))) goto retry;
+				curr = ptr(succ);
+				continue;
+			}
+			if (curr->val.number < key) {  // Still before key, keep going right
+				pred = curr;
+				curr = ptr(succ);
+			}
+			else {
+				break;
+			}
+		}
+		preds[l] = pred;
+		succs[l] = curr;
+	}
+	return curr && curr->val.number == key;
+}
 
-		file.ignore(numeric_limits<streamsize>::max(), '\'');  // Ignore characters until the next single quote
-		if (!getline(file, number, '\'')) break;  // Read the number until the next single quote, break if reading fails
+// Method to snip removed nodes numbered key off every level. Unlike find it looks past a live node with the same
+// number, since a late inserter may have linked a removed one behind it.
+void skipList::purge(const string& key) {
+retry:
+	slNode* before = head;          // Last node numbered below key, where the next level down starts
+	for (int l = SKIP_LEVELS - 1; l >= 0; l--) {
+		slNode* pred = before;
+		for (slNode* curr = ptr(pred->next[l].load()); curr && curr->val.number <= key; ) {
+			uintptr_t succ = curr->next[l].load();
+			if (marked(succ)) {
+				uintptr_t expected = (uintptr_t)curr;
+				if (!pred->next[l].compare_exchange_strong(expected, (uintptr_t)ptr(succ))) goto retry;
+			}
+			else {
+				if (curr->val.number < key) before = curr;
+				pred = curr;
+			}
+			curr = ptr(succ);
+		}
+	}
+}
 
-		temp = person(first_name, last_name, number);  // Create a person object using the names and number
+// Method to let go of a node. Its inserter lets go once it stops linking upper levels, and its remover once level 0
+// is marked; whoever is last knows nobody will link it again, so unlinks it everywhere and retires it.
+void skipList::release(slNode* node, epochRecord& rec) {
+	if (node->owners.fetch_sub(1) != 1) return;
+	purge(node->val.number);
+	retire(node, rec);
+}
 
-		table.retrieve(first_name).retrieve(last_name).insert(temp);  // Insert the person into the hash table
+// Method to put an unlinked node in the bag for the current epoch. A bag still holding an older epoch's nodes is at
+// least EPOCH_BAGS epochs old, so those are freed first.
+void skipList::retire(slNode* node, epochRecord& rec) {
+	uint64_t e = epoch.load();
+	int i = e % EPOCH_BAGS;
+	if (rec.bag[i] && rec.bagEpoch[i] != e) {
+		for (slNode* n = rec.bag[i]; n; ) {
+			slNode* next = n->retiredNext;
+			delete n;
+			n = next;
+			retiredCt--;
+		}
+		rec.bag[i] = nullptr;
 	}
+	rec.bagEpoch[i] = e;
+	node->retiredNext = rec.bag[i];
+	rec.bag[i] = node;
+	retiredCt++;
+	rec.sinceAdvance++;
+}
 
-	file.close();  // Close the file after reading
-
-	table.printAll();  // Print all entries in the hash table
+// Public method to insert a value into the skip list
+bool skipList::insert(person v) {
+	opGuard inside(*this);
+	slNode* preds[SKIP_LEVELS];
+	slNode* succs[SKIP_LEVELS];
+	int top = randomLevel();
+	while (true) {
+		if (find(v.number, preds, succs)) return false;  // Already present; the caller decides whether to say so
 
-	cout << endl << endl << "PRINTING ALL \"Liam\"s:" << endl;  // Output message for printing all "Liam" entries
-	table.retrieve("Liam").printFN("Liam");  // Print all entries with first name "Liam"
-	cout << endl << endl;  // Print two new lines for spacing
+		slNode* node = new slNode(v, top);
+		for (int l = 0; l <= top; l++) node->next[l].store((uintptr_t)succs[l]);
+		uintptr_t expected = (uintptr_t)succs[0];
+		if (!preds[0]->next[0].compare_exchange_strong(expected, (uintptr_t)node)) {  // Level 0 decides whether the node is in
+			delete node;            // Never published, safe to free
+			continue;
+		}
+		count++;
 
-	cout << "REMOVING ALL \"Isabella Anderson\"s:" << endl;  // Output message for removing all "Isabella Anderson" entries
-	table.retrieve("Isabella").retrieve("Anderson").removeFL("Isabella", "Anderson");  // Remove all entries with name "Isabella Anderson"
-	table.printAll();  // Print all entries in the hash table again
-	cout << endl << endl;  // Print two new lines for spacing
+		bool removed = false;       // Set once a remover has marked the node
+		for (int l = 1; l <= top && !removed; l++) {  // Link the upper levels; these are only shortcuts
+			while (true) {
+				uintptr_t link = node->next[l].load();
+				if (marked(link)) {     // Already being removed, stop linking
+					removed = true;
+					break;
+				}
+				if (ptr(link) != succs[l] && !node->next[l].compare_exchange_strong(link, (uintptr_t)succs[l])) continue;
+				expected = (uintptr_t)succs[l];
+				if (preds[l]->next[l].compare_exchange_strong(expected, (uintptr_t)node)) break;
+				find(node->val.number, preds, succs);  // Neighbours changed, look again
+				if (succs[0] != node) { // Removed meanwhile, stop linking
+					removed = true;
+					break;
+				}
+			}
+		}
+		release(node, inside.rec);  // Done linking
+		return true;
+	}
+}
 
-	cout << "PRINTING ALL \"Shaibal Chakrabarty\"s:" << endl;  // Output message for printing all "Shaibal Chakrabarty" entries
+// Public method to retrieve a value by number without modifying the list
+person skipList::retrieve(const string& v) {
+	opGuard inside(*this);
+	slNode* pred = head;
+	slNode* curr = nullptr;
+	for (int l = SKIP_LEVELS - 1; l >= 0; l--) {
+		curr = ptr(pred->next[l].load());
+		while (curr) {
+			uintptr_t succ = curr->next[l].load();
+			if (marked(succ)) {     // Step over removed nodes
+				curr = ptr(succ);
+			}
+			else if (curr->val.number < v) {
+				pred = curr;
+				curr = ptr(succ);
+			}
+			else {
+				break;
+			}
+		}
+	}
+	if (curr && curr->val.number == v) return curr->val;
+	return person();                // Not found, return an empty person
+}
+
+// Public method to remove a value by number
+void skipList::remove(const string& v) {
+	if (!erase(person("NONE", "NONE", v))) cout << "Node not found!" << endl;
+}
+
+// Public method to remove the value with p's number
+bool skipList::erase(const person& p) {
+	opGuard inside(*this);
+	slNode* preds[SKIP_LEVELS];
+	slNode* succs[SKIP_LEVELS];
+	if (!find(p.number, preds, succs)) return false;
+
+	slNode* victim = succs[0];
+	for (int l = victim->top; l >= 1; l--) {  // Mark the upper levels first
+		uintptr_t link = victim->next[l].load();
+		while (!marked(link) && !victim->next[l].compare_exchange_weak(link, link | 1)) {}
+	}
+	uintptr_t link = victim->next[0].load();
+	while (!marked(link)) {          // Whoever marks level 0 is the one who removed it
+		if (victim->next[0].compare_exchange_weak(link, link | 1)) {
+			count--;
+			release(victim, inside.rec);  // Unlinked and retired now, unless its inserter is still linking
+			return true;
+		}
+	}
+	return false;                    // Another thread removed it first
+}
+
+// Public method to remove every value with the given first and last name
+void skipList::removeFL(const string& fn, const string& ln) {
+	vector<string> numbers;          // Numbers to remove, gathered first
+	forEach([&](const person& p) { if (p.first_name == fn && p.last_name == ln) numbers.push_back(p.number); });
+	for (const string& n : numbers) erase(person(fn, ln, n));
+}
+
+// Public method to return the number of live nodes
+int skipList::size() const {
+	return count.load();
+}
+
+// Public method to return the number of retired nodes waiting to be freed
+int skipList::retiredCount() const {
+	return retiredCt.load();
+}
+
+// Public method to visit every live value in order
+template <typename F>
+void skipList::forEach(F&& visit) {
+	opGuard inside(*this);
+	for (slNode* node = ptr(head->next[0].load()); node; node = ptr(node->next[0].load())) {
+		if (!marked(node->next[0].load())) visit(node->val);
+	}
+}
+
+// Public method to print the skip list in order
+void skipList::printAll() {
+	forEach([](const person& p) { cout << p.first_name << ' ' << p.last_name << " : " << p.number << " || "; });
+}
+
+void skipList::printFN(const string& first_name) {
+	forEach([&](const person& p) { if (p.first_name == first_name) cout << p.first_name << ' ' << p.last_name << " : " << p.number << " || "; });
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Fixed-capacity AVL for small buckets: up to N nodes stored inline, linked by 8-bit (N < 255) or 16-bit indices.
+// Nothing is heap-allocated by the tree itself, and for literal types (int, double, ...) every operation works in constexpr.
+
+// Sort key of a value stored in a StaticAVL: the value itself, or a person's number
+template <typename T>
+constexpr const T& staticKey(const T& v) { return v; }
+inline const string& staticKey(const person& p) { return p.number; }
+
+template <typename T, int N>
+class StaticAVL {
+	static_assert(N > 0 && N < 65535, "StaticAVL holds between 1 and 65534 nodes");
+
+public:
+	using index = conditional_t<(N < 255), uint8_t, uint16_t>;  // Smallest index type that can name every node
+	using key_type = decay_t<decltype(staticKey(declval<const T&>()))>;  // Type values are ordered by
+	static constexpr index NIL = numeric_limits<index>::max();  // Index meaning "no node"
+
+	constexpr StaticAVL();                  // Constructor; every node starts on the free list
+	constexpr bool insert(T v);             // Method to insert a value, false if present or the tree is full
+	constexpr T retrieve(const key_type& k) const;  // Method to retrieve a value by key, T() if absent
+	constexpr bool contains(const key_type& k) const;  // Method to check whether a key is present
+	constexpr void remove(const key_type& k);  // Method to remove a value by key
+	constexpr bool erase(const T& v);       // Method to remove the value with v's key, true if it was removed
+	constexpr int size() const;             // Method to return the number of values
+	static constexpr int capacity() { return N; }  // Maximum number of values
+	template <typename F> constexpr void forEach(F&& visit) const;  // Method to call visit on every value in order
+
+	void removeFL(const string& fn, const string& ln);  // Method to remove every person with a first and last name
+	void printAll();                        // Method to print every person in order
+	void printFN(const string& first_name); // Method to print based on first name
+
+private:
+	struct sNode {
+		T val;            // Value stored in the node
+		index left;       // Index of the left child, NIL if none
+		index right;      // Index of the right child (or the next free node while on the free list)
+		uint8_t height;   // Height of the node
+	};
+
+	sNode nodes[N] {};    // Inline node storage
+	index head;           // Index of the root
+	index freeList;       // Index of the first unused node
+	index count;          // Number of values stored
+
+	constexpr int height(index i) const { return i == NIL ? 0 : nodes[i].height; }  // Height of a node, 0 for NIL
+	constexpr void update(index i);                // Method to recompute a node's height
+	constexpr index rotateRight(index y);          // Method to perform a right rotation
+	constexpr index rotateLeft(index x);           // Method to perform a left rotation
+	constexpr index balance(index i);              // Method to balance a node
+	constexpr index insertRec(index i, T& v, bool& added);  // Recursive method to insert and balance
+	constexpr index removeRec(index i, const key_type& k, bool& removed);  // Recursive method to remove and balance
+	template <typename F> constexpr void walk(index i, F& visit) const;  // Recursive method for in-order traversal
+};
+
+template <typename T, int N>
+constexpr StaticAVL<T, N>::StaticAVL() : head(NIL), freeList(0), count(0) {
+	for (int i = 0; i < N; i++) nodes[i].right = i + 1 < N ? i + 1 : NIL;  // Chain every node onto the free list
+}
+
+template <typename T, int N>
+constexpr void StaticAVL<T, N>::update(index i) {
+	int hl = height(nodes[i].left), hr = height(nodes[i].right);
+	nodes[i].height = 1 + (hl > hr ? hl : hr);  // Update the node's height
+}
+
+template <typename T, int N>
+constexpr typename StaticAVL<T, N>::index StaticAVL<T, N>::rotateRight(index y) {
+	index x = nodes[y].left;        // x becomes the new root
+	nodes[y].left = nodes[x].right;
+	nodes[x].right = y;
+	update(y);
+	update(x);
+	return x;
+}
+
+template <typename T, int N>
+constexpr typename StaticAVL<T, N>::index StaticAVL<T, N>::rotateLeft(index x) {
+	index y = nodes[x].right;       // y becomes the new root
+	nodes[x].right = nodes[y].left;
+	nodes[y].left = x;
+	update(x);
+	update(y);
+	return y;
+}
+
+template <typename T, int N>
+constexpr typename StaticAVL<T, N>::index StaticAVL<T, N>::balance(index i) {
+	int balanceFactor = height(nodes[i].left) - height(nodes[i].right);
+	if (balanceFactor > 1) {        // Left-heavy case
+		index l = nodes[i].left;
+		if (height(nodes[l].left) < height(nodes[l].right)) nodes[i].left = rotateLeft(l);  // Left-right case
+		return rotateRight(i);
+	}
+	if (balanceFactor < -1) {       // Right-heavy case
+		index r = nodes[i].right;
+		if (height(nodes[r].right) < height(nodes[r].left)) nodes[i].right = rotateRight(r);  // Right-left case
+		return rotateLeft(i);
+	}
+	return i;
+}
+
+template <typename T, int N>
+constexpr bool StaticAVL<T, N>::insert(T v) {
+	if (contains(staticKey(v))) {
+		if (!is_constant_evaluated()) cout << "Already present, no insert." << endl;
+		return false;
+	}
+	if (freeList == NIL) {          // Every inline node is in use
+		if (!is_constant_evaluated()) cout << "Bucket full, no insert." << endl;
+		return false;
+	}
+	bool added = false;
+	head = insertRec(head, v, added);
+	return added;
+}
+
+template <typename T, int N>
+constexpr typename StaticAVL<T, N>::index StaticAVL<T, N>::insertRec(index i, T& v, bool& added) {
+	if (i == NIL) {                 // Take a node off the free list
+		index n = freeList;
+		freeList = nodes[n].right;
+		nodes[n].val = std::move(v);
+		nodes[n].left = nodes[n].right = NIL;
+		nodes[n].height = 1;
+		count++;
+		added = true;
+		return n;
+	}
+	if (staticKey(v) < staticKey(nodes[i].val)) nodes[i].left = insertRec(nodes[i].left, v, added);
+	else nodes[i].right = insertRec(nodes[i].right, v, added);  // Keys are unique, checked by insert
+	update(i);
+	return balance(i);
+}
+
+template <typename T, int N>
+constexpr T StaticAVL<T, N>::retrieve(const key_type& k) const {
+	index i = head;
+	while (i != NIL) {
+		if (k == staticKey(nodes[i].val)) return nodes[i].val;
+		i = k < staticKey(nodes[i].val) ? nodes[i].left : nodes[i].right;
+	}
+	return T();                     // Not found
+}
+
+template <typename T, int N>
+constexpr bool StaticAVL<T, N>::contains(const key_type& k) const {
+	index i = head;
+	while (i != NIL) {
+		if (k == staticKey(nodes[i].val)) return true;
+		i = k < staticKey(nodes[i].val) ? nodes[i].left : nodes[i].right;
+	}
+	return false;
+}
+
+template <typename T, int N>
+constexpr void StaticAVL<T, N>::remove(const key_type& k) {
+	bool removed = false;
+	head = removeRec(head, k, removed);
+	if (!removed && !is_constant_evaluated()) cout << "Node not found!" << endl;
+}
+
+template <typename T, int N>
+constexpr bool StaticAVL<T, N>::erase(const T& v) {
+	bool removed = false;
+	head = removeRec(head, staticKey(v), removed);
+	return removed;
+}
+
+template <typename T, int N>
+constexpr typename StaticAVL<T, N>::index StaticAVL<T, N>::removeRec(index i, const key_type& k, bool& removed) {
+	if (i == NIL) return NIL;       // Not found
+
+	if (k < staticKey(nodes[i].val)) {
+		nodes[i].left = removeRec(nodes[i].left, k, removed);
+	}
+	else if (staticKey(nodes[i].val) < k) {
+		nodes[i].right = removeRec(nodes[i].right, k, removed);
+	}
+	else if (nodes[i].left == NIL || nodes[i].right == NIL) {  // One or no children: the child takes its place
+		index child = nodes[i].left != NIL ? nodes[i].left : nodes[i].right;
+		nodes[i].right = freeList;  // Return the node to the free list
+		freeList = i;
+		count--;
+		removed = true;
+		return child;
+	}
+	else {                          // Two children: take the successor's value, then remove the successor
+		index s = nodes[i].right;
+		while (nodes[s].left != NIL) s = nodes[s].left;
+		nodes[i].val = nodes[s].val;
+		nodes[i].right = removeRec(nodes[i].right, staticKey(nodes[s].val), removed);
+	}
+	update(i);
+	return balance(i);
+}
+
+template <typename T, int N>
+constexpr int StaticAVL<T, N>::size() const {
+	return count;
+}
+
+template <typename T, int N>
+template <typename F>
+constexpr void StaticAVL<T, N>::forEach(F&& visit) const {
+	walk(head, visit);
+}
+
+template <typename T, int N>
+template <typename F>
+constexpr void StaticAVL<T, N>::walk(index i, F& visit) const {
+	if (i == NIL) return;
+	walk(nodes[i].left, visit);     // Visit the left subtree
+	visit(nodes[i].val);            // Visit the current node's value
+	walk(nodes[i].right, visit);    // Visit the right subtree
+}
+
+template <typename T, int N>
+void StaticAVL<T, N>::removeFL(const string& fn, const string& ln) {
+	vector<string> numbers;         // Numbers to remove, gathered first so the walk is not disturbed
+	forEach([&](const person& p) { if (p.first_name == fn && p.last_name == ln) numbers.push_back(p.number); });
+	for (const string& n : numbers) remove(n);
+}
+
+template <typename T, int N>
+void StaticAVL<T, N>::printAll() {
+	forEach([](const person& p) { cout << p.first_name << ' ' << p.last_name << " : " << p.number << " || "; });
+}
+
+template <typename T, int N>
+void StaticAVL<T, N>::printFN(const string& first_name) {
+	forEach([&](const person& p) { if (p.first_name == first_name) cout << p.first_name << ' ' << p.last_name << " : " << p.number << " || "; });
+}
+
+// Small buckets stay within two cache lines
+static_assert(sizeof(StaticAVL<int, 8>) <= 128, "StaticAVL<int, 8> should fit in two cache lines");
+
+// Everything works at compile time for literal types
+constexpr int staticAVLSelfCheck() {
+	StaticAVL<int, 8> t;
+	for (int v : { 5, 3, 8, 1, 4, 7, 9, 2 }) t.insert(v);
+	t.remove(3);
+	t.erase(9);
+	int sum = 0;
+	t.forEach([&](int v) { sum = sum * 10 + v; });  // Digits in sorted order
+	bool refilled = t.insert(0) && t.insert(6);     // Freed nodes are reused
+	return t.size() == 8 && refilled && !t.insert(10) ? sum : -1;  // A ninth value does not fit
+}
+static_assert(staticAVLSelfCheck() == 124578, "StaticAVL constexpr insert/remove/forEach");
+
+//-----------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Phone-number bucket: numbers in the usual ddd-ddd-dddd form are packed into 64-bit integers and kept in a sorted array,
+// so a lookup compares several keys per instruction (AVX2, when the compiler targets it) instead of one string per tree node.
+// Numbers in any other form go to an ordinary AVL on the side.
+
+// Packs "ddd-ddd-dddd" into its 10 digits as an integer, or returns -1 for any other form; packed order matches string order
+long long packPhone(const string& number) {
+	if (number.size() != 12 || number[3] != '-' || number[7] != '-') return -1;
+	long long key = 0;
+	for (int i = 0; i < 12; i++) {
+		if (i == 3 || i == 7) continue;  // Skip the dashes
+		if (number[i] < '0' || number[i] > '9') return -1;
+		key = key * 10 + (number[i] - '0');
+	}
+	return key;
+}
+
+// Returns how many of the sorted keys[0, n) are less than target
+int lowerBoundPacked(const long long* keys, int n, long long target) {
+	int lo = 0, hi = n;
+	while (hi - lo > 16) {          // Binary search down to a block of at most 16 keys
+		int mid = lo + (hi - lo) / 2;
+		if (keys[mid] < target) lo = mid + 1;
+		else hi = mid;
+	}
+	int i = lo;
+#if defined(__AVX2__)
+	__m256i t = _mm256_set1_epi64x(target);
+	for (; i + 4 <= hi; i += 4) {   // Compare four keys at a time
+		__m256i k = _mm256_loadu_si256((const __m256i*)(keys + i));
+		int less = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(t, k)));  // One bit per key below target
+		if (less != 0xF) return i + popcount((unsigned)less);  // Sorted, so the set bits are the leading ones
+	}
+#endif
+	while (i < hi && keys[i] < target) i++;  // Remaining keys one at a time
+	return i;
+}
+
+// Phone bucket class definition (keyed by number like the AVL)
+class phoneBucket {
+private:
+	vector<long long> keys;         // Packed numbers, sorted
+	vector<person> people;          // people[i] has number keys[i]
+	AVL odd;                        // People whose number is not in ddd-ddd-dddd form
+
+	int find(long long key);        // Method to return the index of key in keys, or -1
+
+public:
+	bool insert(person v);          // Method to insert a value, true if it was added
+	person retrieve(const string& v);  // Method to retrieve a value by number
+	void remove(const string& v);   // Method to remove a value by number
+	bool erase(const person& p);    // Method to remove the value with p's number, true if it was removed
+	void removeFL(const string& fn, const string& ln);  // Method to remove every value with a first and last name
+	int size() const;               // Method to return the number of values
+	template <typename F> void forEach(F&& visit);  // Method to call visit on every value (packed numbers in order, then the rest)
+	void printAll();                // Method to print every value
+	void printFN(const string& first_name);  // Method to print based on first name
+};
+
+// Method to locate a packed key
+int phoneBucket::find(long long key) {
+	int i = lowerBoundPacked(keys.data(), keys.size(), key);
+	return i < (int)keys.size() && keys[i] == key ? i : -1;
+}
+
+// Public method to insert a value
+bool phoneBucket::insert(person v) {
+	long long key = packPhone(v.number);
+	if (key < 0) return odd.insert(std::move(v));  // Unusual form, keep it in the side tree
+
+	int i = lowerBoundPacked(keys.data(), keys.size(), key);
+	if (i < (int)keys.size() && keys[i] == key) {
+		cout << "Already present, no insert." << endl;
+		return false;
+	}
+	keys.insert(keys.begin() + i, key);  // Shift the tail up to keep both arrays sorted
+	people.insert(people.begin() + i, std::move(v));
+	return true;
+}
+
+// Public method to retrieve a value by number
+person phoneBucket::retrieve(const string& v) {
+	long long key = packPhone(v);
+	if (key < 0) return odd.retrieve(v);
+	int i = find(key);
+	return i < 0 ? person() : people[i];
+}
+
+// Public method to remove a value by number
+void phoneBucket::remove(const string& v) {
+	if (!erase(person("NONE", "NONE", v))) cout << "Node not found!" << endl;
+}
+
+// Public method to remove the value with p's number
+bool phoneBucket::erase(const person& p) {
+	long long key = packPhone(p.number);
+	if (key < 0) return odd.erase(p);
+	int i = find(key);
+	if (i < 0) return false;
+	keys.erase(keys.begin() + i);
+	people.erase(people.begin() + i);
+	return true;
+}
+
+// Public method to remove every value with the given first and last name
+void phoneBucket::removeFL(const string& fn, const string& ln) {
+	size_t kept = 0;                // Compact both arrays in one pass
+	for (size_t i = 0; i < people.size(); i++) {
+		if (people[i].first_name == fn && people[i].last_name == ln) continue;
+		if (kept != i) {  // Moving a record onto itself would empty it
+			keys[kept] = keys[i];
+			people[kept] = std::move(people[i]);
+		}
+		kept++;
+	}
+	keys.resize(kept);
+	people.resize(kept);
+	odd.removeFL(fn, ln);
+}
+
+// Public method to return the number of values
+int phoneBucket::size() const {
+	return people.size() + odd.size();
+}
+
+// Public method to visit every value
+template <typename F>
+void phoneBucket::forEach(F&& visit) {
+	for (const person& p : people) visit(p);
+	odd.forEach(visit);
+}
+
+// Public method to print every value
+void phoneBucket::printAll() {
+	forEach([](const person& p) { cout << p.first_name << ' ' << p.last_name << " : " << p.number << " || "; });
+}
+
+void phoneBucket::printFN(const string& first_name) {
+	forEach([&](const person& p) { if (p.first_name == first_name) cout << p.first_name << ' ' << p.last_name << " : " << p.number << " || "; });
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Out-of-core bucket: people kept in a B+tree of fixed-size pages in a temporary file, read through a bounded buffer pool
+
+const int PAGE_SIZE = 4096;    // Bytes per page on disk and per frame in memory
+const int FIELD_LEN = 32;      // Bytes per stored field, including the terminating zero
+const uint32_t NO_PAGE = UINT32_MAX;  // Page id meaning "none"
+
+// Temporary file of fixed-size pages; released pages are reused before the file grows
+class pageFile {
+public:
+	pageFile();                             // Constructor; opens an anonymous temporary file
+	~pageFile();                            // Destructor; the file disappears when closed
+	uint32_t allocate();                    // Method to return the id of an unused page
+	void release(uint32_t id);              // Method to give a page back for reuse
+	void read(uint32_t id, char* buf);      // Method to read a page into buf
+	void write(uint32_t id, const char* buf);  // Method to write buf to a page
+
+	long long reads;   // Pages read from disk
+	long long writes;  // Pages written to disk
+
+private:
+	FILE* file;                  // The temporary file
+	uint32_t pages;              // Pages the file has grown to
+	vector<uint32_t> freed;      // Released pages awaiting reuse
+};
+
+// Constructor for the page file
+pageFile::pageFile() : reads(0), writes(0), file(tmpfile()), pages(0) {
+	if (!file) cerr << "Error: Could not create the page file!" << endl;
+}
+
+// Destructor for the page file
+pageFile::~pageFile() {
+	if (file) fclose(file);
+}
+
+// Public method to allocate a page
+uint32_t pageFile::allocate() {
+	if (freed.empty()) return pages++;
+	uint32_t id = freed.back();
+	freed.pop_back();
+	return id;
+}
+
+// Public method to release a page
+void pageFile::release(uint32_t id) {
+	freed.push_back(id);
+}
+
+// Public method to read a page; pages never written read as zeros
+void pageFile::read(uint32_t id, char* buf) {
+	reads++;
+	memset(buf, 0, PAGE_SIZE);
+	fseek(file, (long)id * PAGE_SIZE, SEEK_SET);
+	if (fread(buf, 1, PAGE_SIZE, file) != (size_t)PAGE_SIZE) clearerr(file);  // Short read past the end of the file
+}
+
+// Public method to write a page
+void pageFile::write(uint32_t id, const char* buf) {
+	writes++;
+	fseek(file, (long)id * PAGE_SIZE, SEEK_SET);
+	if (fwrite(buf, 1, PAGE_SIZE, file) != (size_t)PAGE_SIZE) cerr << "Error: Could not write page " << id << "!" << endl;
+}
+
+// Fixed number of in-memory frames caching pages of one pageFile. Pinned pages stay put; the rest are evicted
+// by CLOCK: the hand sweeps the frames, giving each recently used one a second chance before evicting it.
+class bufferPool {
+public:
+	bufferPool(int frameCt = 256);          // Constructor; frameCt * PAGE_SIZE bytes is the memory budget
+	char* pin(uint32_t id);                 // Method to bring page id into a frame and keep it there until unpinned
+	void unpin(uint32_t id, bool dirty);    // Method to let page id be evicted again; dirty if it was changed
+	void prefetch(uint32_t id);             // Method to read a page ahead of use without pinning it
+	uint32_t allocate();                    // Method to allocate a fresh, zeroed page
+	void release(uint32_t id);              // Method to free a page that is not pinned
+	int frames() const;                     // Method to return the number of frames
+	void resetStats();                      // Method to zero the hit, miss and I/O counters
+
+	long long hits;    // Pins served from memory
+	long long misses;  // Pins that had to read the page
+	pageFile disk;     // Backing file
+
+private:
+	struct alignas(64) frameData { char bytes[PAGE_SIZE]; };  // One page of memory
+	struct frameInfo {
+		uint32_t page = NO_PAGE;  // Page held, or NO_PAGE if the frame is free
+		int pins = 0;             // Outstanding pins
+		bool ref = false;         // Used since the hand last passed
+		bool dirty = false;       // Changed since it was read
+	};
+
+	vector<frameData> data;              // Frame memory
+	vector<frameInfo> info;              // Frame bookkeeping
+	unordered_map<uint32_t, int> where;  // Frame holding each resident page
+	int hand;                            // CLOCK hand
+
+	int claim(uint32_t id);              // Method to pick a frame for page id, writing back whatever it held
+};
+
+// Constructor for the buffer pool; a B+tree insert pins one page per level plus one, so keep a few frames at least
+bufferPool::bufferPool(int frameCt) : hits(0), misses(0), data(max(frameCt, 16)), info(max(frameCt, 16)), hand(0) {}
+
+// Private method to choose a frame by CLOCK and map it to page id
+int bufferPool::claim(uint32_t id) {
+	for (int step = 0; step < 2 * (int)info.size(); step++) {  // Two sweeps clear every second chance
+		int f = hand;
+		hand = (hand + 1) % info.size();
+		if (info[f].pins) continue;      // Pinned pages never move
+		if (info[f].ref) {               // Recently used: spare it this time round
+			info[f].ref = false;
+			continue;
+		}
+		if (info[f].page != NO_PAGE) {   // Evict the old page
+			if (info[f].dirty) disk.write(info[f].page, data[f].bytes);
+			where.erase(info[f].page);
+		}
+		info[f] = frameInfo();
+		info[f].page = id;
+		where[id] = f;
+		return f;
+	}
+	cerr << "Error: Every buffer frame is pinned!" << endl;
+	abort();
+}
+
+// Public method to pin a page
+char* bufferPool::pin(uint32_t id) {
+	auto it = where.find(id);
+	int f;
+	if (it != where.end()) {
+		f = it->second;
+		hits++;
+	}
+	else {
+		f = claim(id);
+		disk.read(id, data[f].bytes);
+		misses++;
+	}
+	info[f].pins++;
+	info[f].ref = true;
+	return data[f].bytes;
+}
+
+// Public method to unpin a page
+void bufferPool::unpin(uint32_t id, bool dirty) {
+	int f = where[id];
+	info[f].pins--;
+	info[f].dirty |= dirty;
+}
+
+// Public method to read a page ahead. It arrives with no second chance, so if it is never used it goes first.
+void bufferPool::prefetch(uint32_t id) {
+	if (id == NO_PAGE || where.count(id)) return;
+	int f = claim(id);
+	disk.read(id, data[f].bytes);
+}
+
+// Public method to allocate a page; it is created in memory, so nothing is read
+uint32_t bufferPool::allocate() {
+	uint32_t id = disk.allocate();
+	auto it = where.find(id);  // A reused page may still be resident
+	int f = it != where.end() ? it->second : claim(id);
+	memset(data[f].bytes, 0, PAGE_SIZE);
+	info[f].dirty = true;
+	return id;
+}
+
+// Public method to free a page
+void bufferPool::release(uint32_t id) {
+	auto it = where.find(id);
+	if (it != where.end()) {  // Drop it from memory without writing it back
+		info[it->second] = frameInfo();
+		where.erase(it);
+	}
+	disk.release(id);
+}
+
+// Public method to return the number of frames
+int bufferPool::frames() const {
+	return info.size();
+}
+
+// Public method to reset the counters
+void bufferPool::resetStats() {
+	hits = misses = disk.reads = disk.writes = 0;
+}
+
+// Keeps a page pinned for as long as the guard lives
+class pinnedPage {
+public:
+	pinnedPage(bufferPool& p, uint32_t page) : pool(p), id(page), bytes(p.pin(page)), dirty(false) {}
+	~pinnedPage() { pool.unpin(id, dirty); }
+	pinnedPage(const pinnedPage&) = delete;
+	pinnedPage& operator=(const pinnedPage&) = delete;
+
+	template <typename T> T* as() { return reinterpret_cast<T*>(bytes); }  // View the page as a node layout
+	void touch() { dirty = true; }  // Mark the page changed
+
+private:
+	bufferPool& pool;  // Pool the page is pinned in
+	uint32_t id;       // Page id
+	char* bytes;       // Frame memory
+	bool dirty;        // True if the page must be written back
+};
+
+// Page layouts for the B+tree
+struct diskRecord {
+	char first[FIELD_LEN];   // First name
+	char last[FIELD_LEN];    // Last name
+	char number[FIELD_LEN];  // Phone number, the key
+};
+
+const int LEAF_MAX = (PAGE_SIZE - 8) / sizeof(diskRecord);              // Records per leaf
+const int INNER_MAX = (PAGE_SIZE - 12) / (FIELD_LEN + sizeof(uint32_t));  // Keys per inner node
+
+struct leafPage {
+	uint8_t leaf;              // 1 for leaves
+	uint16_t n;                // Records held
+	uint32_t next;             // Next leaf in number order, NO_PAGE for the last
+	diskRecord rec[LEAF_MAX];  // Records sorted by number
+};
+
+struct innerPage {
+	uint8_t leaf;                      // 0 for inner nodes
+	uint16_t n;                        // Keys held; there is one more child
+	uint32_t child[INNER_MAX + 1];     // child[i] holds numbers below key[i], child[i + 1] the rest
+	char key[INNER_MAX][FIELD_LEN];    // Separator numbers, sorted
+};
+
+static_assert(sizeof(leafPage) <= PAGE_SIZE && sizeof(innerPage) <= PAGE_SIZE, "B+tree nodes must fit in a page");
+
+// Bucket whose people live in a B+tree keyed by number in a bufferPool's file, so a directory can outgrow memory.
+// Each field is stored in FIELD_LEN bytes, so longer names are refused. Nodes are not merged as they empty;
+// their space is reused by later inserts and given back when the bucket is destroyed.
+class diskBucket {
+public:
+	diskBucket(bufferPool* p = nullptr);    // Constructor; pages go in pool p (nullptr for a default pool shared by all such buckets)
+	diskBucket(const diskBucket& other);    // Copy constructor (copies every person into new pages)
+	diskBucket(diskBucket&& other) noexcept;  // Move constructor
+	diskBucket& operator=(diskBucket other);  // Copy/move assignment
+	~diskBucket();                          // Destructor; frees the bucket's pages
+
+	bool insert(person v);                  // Method to insert a value, true if it was added
+	person retrieve(const string& v) const; // Method to retrieve a value by number
+	void remove(const string& v);           // Method to remove a value by number
+	bool erase(const person& p);            // Method to remove the value with p's number, true if it was removed
+	void removeFL(const string& fn, const string& ln);  // Method to remove every value with a first and last name
+	int size() const;                       // Method to return the number of values
+	template <typename F> void forEach(F&& visit);  // Method to call visit on every value in number order, reading leaves ahead
+	void printAll();                        // Method to print every value
+	void printFN(const string& first_name); // Method to print values with a first name
+
+private:
+	bufferPool* pool;   // Pool holding the pages
+	uint32_t root;      // Root page, NO_PAGE while empty
+	int count;          // Number of values
+
+	static bufferPool& sharedPool();  // Default pool of 256 frames
+
+	int insertRec(uint32_t id, const diskRecord& r, char* upKey, uint32_t& upPage);  // Recursive insert; 1 if the node split, -1 on a duplicate
+	uint32_t leafFor(const char* number) const;  // Method to find the leaf that would hold number
+	void freeRec(uint32_t id);              // Recursive method to free a subtree's pages
+	static person toPerson(const diskRecord& r);  // Method to unpack a record
+};
+
+// Private method to return the default pool
+bufferPool& diskBucket::sharedPool() {
+	static bufferPool pool;
+	return pool;
+}
+
+// Constructor for the bucket; pages are allocated on first insert
+diskBucket::diskBucket(bufferPool* p) : pool(p ? p : &sharedPool()), root(NO_PAGE), count(0) {}
+
+// Copy constructor for the bucket
+diskBucket::diskBucket(const diskBucket& other) : pool(other.pool), root(NO_PAGE), count(0) {
+	const_cast<diskBucket&>(other).forEach([&](const person& p) { insert(p); });  // forEach only reads
+}
+
+// Move constructor for the bucket
+diskBucket::diskBucket(diskBucket&& other) noexcept : pool(other.pool), root(other.root), count(other.count) {
+	other.root = NO_PAGE;  // Leave the source empty
+	other.count = 0;
+}
+
+// Assignment operator for the bucket (copy-and-swap)
+diskBucket& diskBucket::operator=(diskBucket other) {
+	swap(pool, other.pool);
+	swap(root, other.root);
+	swap(count, other.count);
+	return *this;
+}
+
+// Destructor for the bucket
+diskBucket::~diskBucket() {
+	if (root != NO_PAGE) freeRec(root);
+}
+
+// Private method to free every page below id
+void diskBucket::freeRec(uint32_t id) {
+	{
+		pinnedPage page(*pool, id);
+		innerPage* node = page.as<innerPage>();
+		if (!node->leaf) {
+			for (int i = 0; i <= node->n; i++) freeRec(node->child[i]);
+		}
+	}
+	pool->release(id);
+}
+
+// Private method to unpack a record
+person diskBucket::toPerson(const diskRecord& r) {
+	return person(r.first, r.last, r.number);
+}
+
+// Private method to find the leaf for a number
+uint32_t diskBucket::leafFor(const char* number) const {
+	uint32_t id = root;
+	while (true) {
+		pinnedPage page(*pool, id);
+		innerPage* node = page.as<innerPage>();
+		if (node->leaf) return id;
+		int i = 0;
+		while (i < node->n && strcmp(number, node->key[i]) >= 0) i++;  // Numbers equal to a separator live on its right
+		id = node->child[i];
+	}
+}
+
+// Public method to insert a value
+bool diskBucket::insert(person v) {
+	if (v.first_name.size() >= FIELD_LEN || v.last_name.size() >= FIELD_LEN || v.number.size() >= FIELD_LEN) {
+		cout << "Too long for disk storage, no insert." << endl;
+		return false;
+	}
+	diskRecord r = {};
+	memcpy(r.first, v.first_name.c_str(), v.first_name.size());
+	memcpy(r.last, v.last_name.c_str(), v.last_name.size());
+	memcpy(r.number, v.number.c_str(), v.number.size());
+
+	if (root == NO_PAGE) {  // First value: the root starts as an empty leaf
+		root = pool->allocate();
+		pinnedPage page(*pool, root);
+		page.as<leafPage>()->leaf = 1;
+		page.as<leafPage>()->next = NO_PAGE;
+		page.touch();
+	}
+
+	char upKey[FIELD_LEN];
+	uint32_t upPage;
+	int split = insertRec(root, r, upKey, upPage);
+	if (split < 0) {
+		cout << "Already present, no insert." << endl;
+		return false;
+	}
+	if (split) {  // The root split: grow a level
+		uint32_t id = pool->allocate();
+		pinnedPage page(*pool, id);
+		innerPage* node = page.as<innerPage>();
+		node->leaf = 0;
+		node->n = 1;
+		node->child[0] = root;
+		node->child[1] = upPage;
+		memcpy(node->key[0], upKey, FIELD_LEN);
+		page.touch();
+		root = id;
+	}
+	count++;
+	return true;
+}
+
+// Private method to insert below page id. On a split the new right sibling and its first key are passed up.
+int diskBucket::insertRec(uint32_t id, const diskRecord& r, char* upKey, uint32_t& upPage) {
+	pinnedPage page(*pool, id);
+	if (page.as<leafPage>()->leaf) {
+		leafPage* node = page.as<leafPage>();
+		int i = 0;
+		while (i < node->n && strcmp(node->rec[i].number, r.number) < 0) i++;
+		if (i < node->n && strcmp(node->rec[i].number, r.number) == 0) return -1;
+		page.touch();
+		if (node->n < LEAF_MAX) {  // Room here: shift the tail up
+			memmove(&node->rec[i + 1], &node->rec[i], (node->n - i) * sizeof(diskRecord));
+			node->rec[i] = r;
+			node->n++;
+			return 0;
+		}
+
+		vector<diskRecord> all(node->rec, node->rec + node->n);  // Full: split the records evenly with the new one included
+		all.insert(all.begin() + i, r);
+		upPage = pool->allocate();
+		pinnedPage right(*pool, upPage);
+		leafPage* sib = right.as<leafPage>();
+		int half = all.size() / 2;
+		sib->leaf = 1;
+		sib->n = all.size() - half;
+		sib->next = node->next;
+		copy(all.begin() + half, all.end(), sib->rec);
+		node->n = half;
+		node->next = upPage;
+		copy(all.begin(), all.begin() + half, node->rec);
+		memcpy(upKey, sib->rec[0].number, FIELD_LEN);
+		right.touch();
+		return 1;
+	}
+
+	innerPage* node = page.as<innerPage>();
+	int i = 0;
+	while (i < node->n && strcmp(r.number, node->key[i]) >= 0) i++;
+	char childKey[FIELD_LEN];
+	uint32_t childPage;
+	int split = insertRec(node->child[i], r, childKey, childPage);
+	if (split <= 0) return split;
+
+	page.touch();
+	if (node->n < INNER_MAX) {  // Room here for the child's new sibling
+		memmove(node->key[i + 1], node->key[i], (node->n - i) * FIELD_LEN);
+		memmove(&node->child[i + 2], &node->child[i + 1], (node->n - i) * sizeof(uint32_t));
+		memcpy(node->key[i], childKey, FIELD_LEN);
+		node->child[i + 1] = childPage;
+		node->n++;
+		return 0;
+	}
+
+	vector<string> keys;  // Full: split around the middle key, which moves up
+	vector<uint32_t> kids(node->child, node->child + node->n + 1);
+	for (int k = 0; k < node->n; k++) keys.push_back(node->key[k]);
+	keys.insert(keys.begin() + i, childKey);
+	kids.insert(kids.begin() + i + 1, childPage);
+	int mid = keys.size() / 2;
+
+	upPage = pool->allocate();
+	pinnedPage right(*pool, upPage);
+	innerPage* sib = right.as<innerPage>();
+	sib->leaf = 0;
+	sib->n = keys.size() - mid - 1;
+	for (int k = 0; k < sib->n; k++) strcpy(sib->key[k], keys[mid + 1 + k].c_str());
+	copy(kids.begin() + mid + 1, kids.end(), sib->child);
+	node->n = mid;
+	for (int k = 0; k < mid; k++) strcpy(node->key[k], keys[k].c_str());
+	copy(kids.begin(), kids.begin() + mid + 1, node->child);
+	memset(upKey, 0, FIELD_LEN);
+	strcpy(upKey, keys[mid].c_str());
+	right.touch();
+	return 1;
+}
+
+// Public method to retrieve a value by number
+person diskBucket::retrieve(const string& v) const {
+	if (root == NO_PAGE || v.size() >= FIELD_LEN) return person();
+	pinnedPage page(*pool, leafFor(v.c_str()));
+	leafPage* node = page.as<leafPage>();
+	for (int i = 0; i < node->n; i++) {
+		if (v == node->rec[i].number) return toPerson(node->rec[i]);
+	}
+	return person();
+}
+
+// Public method to remove a value by number
+void diskBucket::remove(const string& v) {
+	if (!erase(person("NONE", "NONE", v))) cout << "Node not found!" << endl;
+}
+
+// Public method to remove the value with p's number
+bool diskBucket::erase(const person& p) {
+	if (root == NO_PAGE || p.number.size() >= FIELD_LEN) return false;
+	pinnedPage page(*pool, leafFor(p.number.c_str()));
+	leafPage* node = page.as<leafPage>();
+	for (int i = 0; i < node->n; i++) {
+		if (p.number == node->rec[i].number) {
+			memmove(&node->rec[i], &node->rec[i + 1], (node->n - i - 1) * sizeof(diskRecord));
+			node->n--;
+			page.touch();
+			count--;
+			return true;
+		}
+	}
+	return false;
+}
+
+// Public method to remove every value with the given first and last name
+void diskBucket::removeFL(const string& fn, const string& ln) {
+	vector<string> numbers;  // Collect first; erasing during the scan would move records under it
+	forEach([&](const person& p) { if (p.first_name == fn && p.last_name == ln) numbers.push_back(p.number); });
+	for (const string& n : numbers) erase(person(fn, ln, n));
+}
+
+// Public method to return the number of values
+int diskBucket::size() const {
+	return count;
+}
+
+// Public method to visit every value in number order. Each leaf is copied out and unpinned before its values are
+// visited, and the next leaf is read ahead meanwhile.
+template <typename F>
+void diskBucket::forEach(F&& visit) {
+	if (root == NO_PAGE) return;
+	uint32_t id = root;
+	while (true) {  // Down the left edge to the first leaf
+		pinnedPage page(*pool, id);
+		innerPage* node = page.as<innerPage>();
+		if (node->leaf) break;
+		id = node->child[0];
+	}
+	vector<person> batch;  // Values of the current leaf
+	while (id != NO_PAGE) {
+		batch.clear();
+		{
+			pinnedPage page(*pool, id);
+			leafPage* node = page.as<leafPage>();
+			for (int i = 0; i < node->n; i++) batch.push_back(toPerson(node->rec[i]));
+			id = node->next;
+		}
+		pool->prefetch(id);  // Read ahead while this leaf is visited
+		for (const person& p : batch) visit(p);
+	}
+}
+
+// Public method to print every value
+void diskBucket::printAll() {
+	forEach([](const person& p) { cout << p.first_name << ' ' << p.last_name << " : " << p.number << " || "; });
+}
+
+void diskBucket::printFN(const string& first_name) {
+	forEach([&](const person& p) { if (p.first_name == first_name) cout << p.first_name << ' ' << p.last_name << " : " << p.number << " || "; });
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------------------------------------------
+//Hash Table
+
+// Function to generate a list of small prime numbers up to a limit
+std::vector<int>* generate_small_primes(int limit) {
+	std::vector<int>* primes = new vector<int>;  // Dynamically allocate a vector of integers
+	primes->push_back(2);          // Add 2 as the first prime number
+
+	for (int i = 3; i <= limit; i += 2) {  // Check only odd numbers
+		bool is_prime = true;      // Assume the number is prime
+		for (int prime : *primes) { // Check divisibility by smaller primes
+			if (prime * prime > i) break; // Stop if the prime exceeds the square root of the number
+			if (i % prime == 0) {  // If divisible, it's not a prime
+				is_prime = false;
+				break;
+			}
+		}
+		if (is_prime) {            // If still prime, add it to the list
+			primes->push_back(i);
+		}
+	}
+	return primes;                 // Return the list of primes
+}
+
+// Helper function to check if a number is prime using a list of smaller prime numbers
+//Will not work properly if not all primes < sqrt(num) are on primes list
+bool is_prime(int num, const std::vector<int>* primes) {
+	if (num <= 1) return false;    // Numbers less than or equal to 1 are not prime
+	if (num == 2) return true;     // 2 is prime
+	if (num % 2 == 0) return false; // Even numbers greater than 2 are not prime
+
+	// Check divisibility by smaller primes up to sqrt(num)
+	int limit = std::sqrt(num);    // Calculate the square root of the number
+	for (int prime : *primes) {    // Iterate through the list of smaller primes
+		if (prime > limit) break;  // If the prime exceeds the limit, stop
+		if (num % prime == 0) {    // If the number is divisible by any prime, it's not prime
+			return false;
+		}
+	}
+	return true;                   // Return true if no divisor was found (prime number)
+}
+
+// Function to find the next prime number greater than or equal to `n`
+int next_prime(int n) {
+	if (n <= 2) return 2;          // Return 2 if the input is less than or equal to 2
+
+	if (n % 2 == 0) n++;           // If the number is even, start with the next odd number
+
+	vector<int>* small_primes = generate_small_primes(std::sqrt(n) + 1); // Pre-generate small primes
+
+	while (!is_prime(n, small_primes)) { // Check if the current number is prime
+		n += 2;                  // Increment by 2 to skip even numbers
+	}
+
+	delete small_primes;           // Free the memory used by the small primes vector
+
+	return n;                      // Return the next prime number
+}
+
+// FNV-1a hash of a string, shared by the hash table and the sketches
+unsigned long long fnv1a(const string& key) {
+	const unsigned long long fnv_prime = 1099511628211ULL;  // FNV prime number constant
+	unsigned long long hash = 14695981039346656037ULL;  // FNV offset basis
+
+	for (char c : key) {  // Loop through each character in the key
+		hash ^= c;  // XOR the character with the hash
+		hash *= fnv_prime;  // Multiply the hash by the FNV prime
+	}
+
+	return hash;  // Return the computed hash value
+}
+
+// Streaming frequency statistics for one field: a count-min sketch estimates any key's count,
+// and a Space-Saving summary of k counters (kept as a min-heap) tracks the most common keys.
+// Each add is O(depth + log k), cheap enough to run inline while loading.
+class heavyHitters {
+public:
+	heavyHitters(int k = 64, int width = 1024, int depth = 4);  // Constructor; k counters catch every key more common than 1/k of the stream
+
+	void add(const string& key);  // Method to count one occurrence of key
+	int estimate(const string& key) const;  // Method to return key's estimated count (never below the true count)
+	vector<pair<string, int>> top(int m) const;  // Method to return the m most common tracked keys, most common first
+	int total() const;  // Number of keys added
+
+private:
+	struct counter {
+		string key;   // Tracked key
+		int count;    // Space-Saving count (true count plus at most error)
+		int error;    // Count the key may have inherited when it took over a counter
+	};
+
+	int k;                    // Number of counters in the summary
+	int width;                // Counters per sketch row
+	int depth;                // Sketch rows
+	int n;                    // Number of keys added
+	vector<int> sketch;       // depth rows of width counters
+	vector<counter> heap;     // Min-heap of counters by count
+	unordered_map<string, int> where;  // Heap index of each tracked key
+
+	void siftDown(int i);     // Method to restore the heap below index i
+};
+
+// Constructor for the heavy-hitter tracker
+heavyHitters::heavyHitters(int k, int width, int depth) : k(k), width(width), depth(depth), n(0), sketch(width * depth, 0) {}
+
+// Public method to count one occurrence of key
+void heavyHitters::add(const string& key) {
+	n++;
+	unsigned long long h = fnv1a(key);
+	unsigned h1 = h, h2 = (h >> 32) | 1;  // Double hashing gives each row its own hash
+	for (int row = 0; row < depth; row++) {
+		sketch[row * width + (h1 + row * h2) % width]++;
+	}
+
+	auto found = where.find(key);
+	if (found != where.end()) {           // Already tracked: bump its counter
+		heap[found->second].count++;
+		siftDown(found->second);
+	}
+	else if ((int)heap.size() < k) {      // Room for another counter
+		heap.push_back({ key, 1, 0 });
+		where[key] = heap.size() - 1;
+		for (int i = heap.size() - 1; i > 0 && heap[(i - 1) / 2].count > heap[i].count; i = (i - 1) / 2) {  // Sift the new counter up
+			swap(heap[i], heap[(i - 1) / 2]);
+			where[heap[i].key] = i;
+			where[heap[(i - 1) / 2].key] = (i - 1) / 2;
+		}
+	}
+	else {                                // Take over the smallest counter
+		where.erase(heap[0].key);
+		heap[0].error = heap[0].count;
+		heap[0].count++;
+		heap[0].key = key;
+		where[key] = 0;
+		siftDown(0);
+	}
+}
+
+// Method to move heap[i] down until its children are no smaller
+void heavyHitters::siftDown(int i) {
+	int size = heap.size();
+	while (true) {
+		int smallest = i;
+		int l = 2 * i + 1, r = 2 * i + 2;
+		if (l < size && heap[l].count < heap[smallest].count) smallest = l;
+		if (r < size && heap[r].count < heap[smallest].count) smallest = r;
+		if (smallest == i) return;
+		swap(heap[i], heap[smallest]);
+		where[heap[i].key] = i;
+		where[heap[smallest].key] = smallest;
+		i = smallest;
+	}
+}
+
+// Public method to return key's estimated count
+int heavyHitters::estimate(const string& key) const {
+	unsigned long long h = fnv1a(key);
+	unsigned h1 = h, h2 = (h >> 32) | 1;
+	int best = numeric_limits<int>::max();
+	for (int row = 0; row < depth; row++) {  // Every row overcounts, so the smallest is closest
+		int c = sketch[row * width + (h1 + row * h2) % width];
+		if (c < best) best = c;
+	}
+	return best;
+}
+
+// Public method to return the m tracked keys with the highest estimated counts, most common first
+vector<pair<string, int>> heavyHitters::top(int m) const {
+	vector<pair<string, int>> out;
+	for (const counter& c : heap) out.push_back({ c.key, min(c.count, estimate(c.key)) });  // Both bounds are high, so take the tighter
+	sort(out.begin(), out.end(), [](const pair<string, int>& a, const pair<string, int>& b) { return a.second > b.second; });
+	if ((int)out.size() > m) out.resize(m);
+	return out;
+}
+
+// Public method to return the number of keys added
+int heavyHitters::total() const {
+	return n;
+}
+
+// HyperLogLog distinct-count sketch: 2^P one-byte registers, each keeping the longest run of leading zeros seen among the
+// hashes routed to it. Standard error is about 1.04 / sqrt(2^P) (1.6% for P = 12). Two sketches merge by register-wise max.
+class hyperLogLog {
+public:
+	static const int P = 12;               // Bits of the hash that pick a register
+	static const int REGISTERS = 1 << P;   // Number of registers
+
+	hyperLogLog();                         // Constructor; all registers start at zero
+	void add(const string& key);           // Method to record key
+	void merge(const hyperLogLog& other);  // Method to fold in another sketch, as if its keys had been added here
+	double estimate() const;               // Method to return the estimated number of distinct keys
+
+private:
+	uint8_t reg[REGISTERS];                // Registers
+};
+
+// Constructor for the sketch
+hyperLogLog::hyperLogLog() : reg{} {}
+
+// Public method to record a key
+void hyperLogLog::add(const string& key) {
+	unsigned long long h = fnv1a(key);     // FNV-1a alone mixes short keys poorly, so finish with the splitmix64 mixer
+	h ^= h >> 30;
+	h *= 0xbf58476d1ce4e5b9ULL;
+	h ^= h >> 27;
+	h *= 0x94d049bb133111ebULL;
+	h ^= h >> 31;
+
+	int index = h >> (64 - P);             // Top P bits pick the register
+	unsigned long long rest = h << P;      // The remaining bits give the rank
+	uint8_t rank = rest ? countl_zero(rest) + 1 : 64 - P + 1;
+	if (rank > reg[index]) reg[index] = rank;
+}
+
+// Public method to merge another sketch into this one, 16 or 32 registers per instruction where available
+void hyperLogLog::merge(const hyperLogLog& other) {
+	int i = 0;
+#if defined(__AVX2__)
+	for (; i + 32 <= REGISTERS; i += 32) {
+		__m256i a = _mm256_loadu_si256((const __m256i*)(reg + i));
+		__m256i b = _mm256_loadu_si256((const __m256i*)(other.reg + i));
+		_mm256_storeu_si256((__m256i*)(reg + i), _mm256_max_epu8(a, b));
+	}
+#elif defined(__SSE2__) || defined(_M_X64)
+	for (; i + 16 <= REGISTERS; i += 16) {
+		__m128i a = _mm_loadu_si128((const __m128i*)(reg + i));
+		__m128i b = _mm_loadu_si128((const __m128i*)(other.reg + i));
+		_mm_storeu_si128((__m128i*)(reg + i), _mm_max_epu8(a, b));
+	}
+#endif
+	for (; i < REGISTERS; i++) {           // Whatever is left (everything, without SIMD)
+		if (other.reg[i] > reg[i]) reg[i] = other.reg[i];
+	}
+}
+
+// Public method to return the estimated number of distinct keys
+double hyperLogLog::estimate() const {
+	double sum = 0;                        // Sum of 2^-register
+	int zeros = 0;                         // Registers never touched
+	for (int i = 0; i < REGISTERS; i++) {
+		sum += ldexp(1.0, -reg[i]);
+		if (!reg[i]) zeros++;
+	}
+	double alpha = 0.7213 / (1 + 1.079 / REGISTERS);  // Bias correction for large register counts
+	double raw = alpha * REGISTERS * REGISTERS / sum;
+	if (raw <= 2.5 * REGISTERS && zeros) {  // Small cardinalities: linear counting is more accurate
+		return REGISTERS * log((double)REGISTERS / zeros);
+	}
+	return raw;
+}
+
+// Distinct-count sketches for each person field. Attach one to a directory with hashTable::setStats;
+// give each shard or thread its own and merge them for the totals. People who are later removed stay counted.
+struct directoryStats {
+	hyperLogLog firstNames;   // Distinct first names
+	hyperLogLog lastNames;    // Distinct last names
+	hyperLogLog numbers;      // Distinct phone numbers
+
+	void add(const person& p) {  // Record one person's fields
+		firstNames.add(p.first_name);
+		lastNames.add(p.last_name);
+		numbers.add(p.number);
+	}
+
+	void merge(const directoryStats& other) {  // Fold in another shard's sketches
+		firstNames.merge(other.firstNames);
+		lastNames.merge(other.lastNames);
+		numbers.merge(other.numbers);
+	}
+};
+
+//-----------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Phone numbers shared by different people. Buckets only reject a repeated number inside themselves, so the same
+// number can sit under two different names in different buckets.
+
+// Incremental check: attach to a directory with hashTable::setNumberRegistry and every insert is checked as it happens.
+// Removals made directly on a bucket (via retrieve) bypass it, so holders removed that way still count; remove through
+// hashTable::erase or hashTable::removeFL instead.
+class numberRegistry {
+public:
+	bool add(const person& p);     // Method to record p as holding its number; false (and the pair is reported) if someone else already does
+	void remove(const person& p);  // Method to forget p's hold on its number
+	const vector<pair<person, person>>& reported() const;  // Every (newcomer, existing holder) pair seen by add
+
+private:
+	unordered_map<string, vector<person>> holders;  // People holding each number
+	vector<pair<person, person>> shared;            // Pairs reported so far
+};
+
+// Public method to record a person's number
+bool numberRegistry::add(const person& p) {
+	vector<person>& held = holders[p.number];
+	bool alone = true;  // True unless someone with another name holds the number
+	for (const person& other : held) {
+		if (other.first_name != p.first_name || other.last_name != p.last_name) {
+			shared.emplace_back(p, other);
+			alone = false;
+		}
+	}
+	held.push_back(p);
+	return alone;
+}
+
+// Public method to forget a person's number
+void numberRegistry::remove(const person& p) {
+	auto it = holders.find(p.number);
+	if (it == holders.end()) return;
+	vector<person>& held = it->second;
+	for (size_t i = 0; i < held.size(); i++) {
+		if (held[i].first_name == p.first_name && held[i].last_name == p.last_name) {
+			held.erase(held.begin() + i);
+			break;
+		}
+	}
+	if (held.empty()) holders.erase(it);
+}
+
+// Public method to return the reported pairs
+const vector<pair<person, person>>& numberRegistry::reported() const {
+	return shared;
+}
+
+const int JOIN_SERIAL_CUTOFF = 4096;  // Below this many people one thread beats the cost of starting more
+
+// Full pass: a partitioned hash self-join on number. Each thread scatters its share of the people into partitions
+// by number hash, then threads claim whole partitions and join them with no shared state. Returns each group of
+// people holding the same number under more than one name, sorted by number.
+template <typename Directory>
+vector<vector<person>> findSharedNumbers(Directory& dir, int threads = thread::hardware_concurrency()) {
+	vector<person> all;  // Everyone, so threads can split the work by index
+	all.reserve(dir.size());
+	dir.forEach([&](const person& p) { all.push_back(p); });
+	if (threads < 1 || (int)all.size() < JOIN_SERIAL_CUTOFF) threads = 1;
+	int parts = threads * 8;  // Several partitions per thread so a skewed one does not hold everyone up
+
+	// Scatter: thread t sends its slice of all to local[t][partition]
+	vector<vector<vector<int>>> local(threads, vector<vector<int>>(parts));
+	auto scatter = [&](int t) {
+		size_t lo = all.size() * t / threads, hi = all.size() * (t + 1) / threads;
+		for (size_t i = lo; i < hi; i++) local[t][(fnv1a(all[i].number) >> 32) % parts].push_back((int)i);
+	};
+
+	// Join: claim partitions until none are left; each is built into its own map and scanned for shared numbers
+	atomic<int> nextPart(0);
+	vector<vector<vector<person>>> found(threads);  // Groups found by each thread
+	auto join = [&](int t) {
+		for (int part; (part = nextPart.fetch_add(1)) < parts; ) {
+			unordered_map<string_view, vector<int>> byNumber;
+			for (int s = 0; s < threads; s++) {
+				for (int i : local[s][part]) byNumber[all[i].number].push_back(i);
+			}
+			for (auto& [number, who] : byNumber) {
+				if (who.size() < 2) continue;
+				bool mixed = false;  // True once two of them have different names
+				for (int i : who) mixed |= all[i].first_name != all[who[0]].first_name || all[i].last_name != all[who[0]].last_name;
+				if (!mixed) continue;
+				vector<person> group;
+				for (int i : who) group.push_back(all[i]);
+				found[t].push_back(std::move(group));
+			}
+		}
+	};
+
+	for (auto phase : { function<void(int)>(scatter), function<void(int)>(join) }) {  // The scatter must finish before any join starts
+		vector<thread> workers;
+		for (int t = 1; t < threads; t++) workers.emplace_back(phase, t);
+		phase(0);  // This thread takes a share too
+		for (thread& w : workers) w.join();
+	}
+
+	vector<vector<person>> groups;
+	for (auto& f : found) for (auto& g : f) groups.push_back(std::move(g));
+	sort(groups.begin(), groups.end(), [](const vector<person>& a, const vector<person>& b) { return a[0].number < b[0].number; });
+	return groups;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Write-optimized bucket: an in-memory sorted memtable that is flushed, when full, into an immutable sorted run on disk.
+// Lookups check the memtable, then the runs newest first, skipping any run whose Bloom filter rules the number out.
+
+// Bloom filter with about 1% false positives at 10 bits per key
+class bloomFilter {
+public:
+	bloomFilter(int expected = 0);          // Constructor; sized for the expected number of keys
+	void add(const string& key);            // Method to record key
+	bool mayContain(pair<uint64_t, uint64_t> h) const;  // Method to check a key by its hashes; false means definitely absent
+	static pair<uint64_t, uint64_t> hashes(const string& key);  // Two independent hashes, combined for each probe; compute once to check many filters
+
+private:
+	static const int HASHES = 7;            // Bits set per key
+	vector<uint64_t> bits;                  // Bit array
+};
+
+// Constructor for the filter
+bloomFilter::bloomFilter(int expected) : bits(max(expected * 10 / 64 + 1, 1)) {}
+
+// Public method to hash a key twice; probe i uses h1 + i * h2
+pair<uint64_t, uint64_t> bloomFilter::hashes(const string& key) {
+	uint64_t h = fnv1a(key);
+	uint64_t h2 = (h ^ (h >> 31)) * 0x94d049bb133111ebULL;  // Remix for the second hash
+	return { h, h2 | 1 };
+}
+
+// Public method to record a key
+void bloomFilter::add(const string& key) {
+	auto [h1, h2] = hashes(key);
+	uint64_t n = bits.size() * 64;
+	for (int i = 0; i < HASHES; i++) {
+		uint64_t bit = (h1 + i * h2) % n;
+		bits[bit / 64] |= 1ULL << (bit % 64);
+	}
+}
+
+// Public method to check a key
+bool bloomFilter::mayContain(pair<uint64_t, uint64_t> h) const {
+	auto [h1, h2] = h;
+	uint64_t n = bits.size() * 64;
+	for (int i = 0; i < HASHES; i++) {
+		uint64_t bit = (h1 + i * h2) % n;
+		if (!(bits[bit / 64] >> (bit % 64) & 1)) return false;
+	}
+	return true;
+}
+
+// Immutable file of records sorted by number, written once. A sparse index of every INDEX_EVERY-th number lets a
+// lookup seek straight to one short stretch of the file. Tombstones record removals that older runs must not show.
+class sortedRun {
+public:
+	struct entry {
+		person p;        // The record
+		bool tombstone;  // True if this number was removed
+	};
+
+	sortedRun(const vector<entry>& sorted);  // Constructor; writes the entries (sorted by number, unique) to a new file
+	~sortedRun();                           // Destructor; the file disappears when closed
+
+	// Position in a sequential read of the run. Entries are read INDEX_EVERY at a time, retaking the lock for each
+	// stretch, so lookups are not held up by a long scan.
+	class cursor {
+	public:
+		cursor(sortedRun& r) : run(&r), at(0), left(r.count), pos(0) { next(); }
+		void next();                        // Method to move to the following entry
+		bool valid;                         // False once past the last entry
+		entry cur;                          // Current entry
+	private:
+		sortedRun* run;                     // Run being read
+		long at;                            // Offset of the next stretch
+		int left;                           // Entries not yet read from the file
+		vector<entry> ahead;                // Current stretch
+		size_t pos;                         // Next entry in ahead
+	};
+
+	bool find(const string& number, pair<uint64_t, uint64_t> h, entry& out);  // Method to look a number up given its Bloom hashes, true if the run has an entry for it
+	int size() const;                       // Method to return the number of entries
+
+private:
+	static const int INDEX_EVERY = 32;      // Entries per sparse index step
+	FILE* file;                             // The run's file
+	int count;                              // Entries in the file
+	bloomFilter bloom;                      // Numbers in the run
+	vector<pair<string, long>> index;       // (first number, file offset) of every INDEX_EVERY-th entry
+	mutex io;                               // The compactor and lookups share the file position
+
+	static void writeField(FILE* f, const string& s);  // Method to write a length-prefixed string
+	static bool readField(FILE* f, string& s);         // Method to read a length-prefixed string
+	static bool readEntry(FILE* f, entry& e);          // Method to read one entry at the file position
+};
+
+// Constructor for the run
+sortedRun::sortedRun(const vector<entry>& sorted) : file(tmpfile()), count(sorted.size()), bloom(sorted.size()) {
+	if (!file) {
+		cerr << "Error: Could not create a run file!" << endl;
+		count = 0;
+		return;
+	}
+	for (int i = 0; i < count; i++) {
+		const entry& e = sorted[i];
+		if (i % INDEX_EVERY == 0) index.emplace_back(e.p.number, ftell(file));
+		bloom.add(e.p.number);
+		fputc(e.tombstone, file);
+		writeField(file, e.p.first_name);
+		writeField(file, e.p.last_name);
+		writeField(file, e.p.number);
+	}
+	fflush(file);
+}
+
+// Destructor for the run
+sortedRun::~sortedRun() {
+	if (file) fclose(file);
+}
+
+// Private method to write a string with its length in front
+void sortedRun::writeField(FILE* f, const string& s) {
+	uint16_t len = s.size();
+	fwrite(&len, sizeof len, 1, f);
+	fwrite(s.data(), 1, len, f);
+}
+
+// Private method to read a string with its length in front
+bool sortedRun::readField(FILE* f, string& s) {
+	uint16_t len;
+	if (fread(&len, sizeof len, 1, f) != 1) return false;
+	s.resize(len);
+	return fread(s.data(), 1, len, f) == len;
+}
+
+// Private method to read one entry
+bool sortedRun::readEntry(FILE* f, entry& e) {
+	int flag = fgetc(f);
+	if (flag == EOF) return false;
+	e.tombstone = flag;
+	return readField(f, e.p.first_name) && readField(f, e.p.last_name) && readField(f, e.p.number);
+}
+
+// Public method to look up a number
+bool sortedRun::find(const string& number, pair<uint64_t, uint64_t> h, entry& out) {
+	if (!count || !bloom.mayContain(h)) return false;  // Most misses end here, with no I/O
+	auto step = upper_bound(index.begin(), index.end(), number, [](const string& n, const pair<string, long>& s) { return n < s.first; });
+	if (step == index.begin()) return false;  // Below the first number in the run
+	--step;
+
+	lock_guard<mutex> hold(io);
+	fseek(file, step->second, SEEK_SET);
+	entry e;
+	for (int i = 0; i < INDEX_EVERY && readEntry(file, e); i++) {  // Scan this stretch only
+		if (e.p.number == number) {
+			out = e;
+			return true;
+		}
+		if (e.p.number > number) break;
+	}
+	return false;
+}
+
+// Public method to advance a cursor
+void sortedRun::cursor::next() {
+	if (pos == ahead.size()) {  // Read the next stretch
+		ahead.clear();
+		pos = 0;
+		lock_guard<mutex> hold(run->io);
+		fseek(run->file, at, SEEK_SET);
+		entry e;
+		while (left > 0 && (int)ahead.size() < INDEX_EVERY && readEntry(run->file, e)) {
+			ahead.push_back(std::move(e));
+			left--;
+		}
+		at = ftell(run->file);
+	}
+	valid = pos < ahead.size();
+	if (valid) cur = std::move(ahead[pos++]);
+}
+
+// Public method to return the number of entries
+int sortedRun::size() const {
+	return count;
+}
+
+// Bucket built from a memtable and sorted runs. insert/erase touch only the memtable, so ingest costs a memtable insert
+// plus, every memtableLimit changes, one sequential file write. Once RUNS_BEFORE_COMPACT runs pile up a background
+// thread merges them into one, dropping shadowed entries and tombstones.
+class lsmBucket {
+public:
+	lsmBucket();                            // Constructor
+	lsmBucket(const lsmBucket& other);      // Copy constructor; runs are immutable, so they are shared
+	lsmBucket(lsmBucket&& other) noexcept;  // Move constructor
+	lsmBucket& operator=(lsmBucket other);  // Copy/move assignment
+	~lsmBucket();                           // Destructor; waits for any compaction
+
+	bool insert(person v);                  // Method to insert a value, true if it was added
+	person retrieve(const string& v);       // Method to retrieve a value by number
+	void remove(const string& v);           // Method to remove a value by number
+	bool erase(const person& p);            // Method to remove the value with p's number, true if it was removed
+	void removeFL(const string& fn, const string& ln);  // Method to remove every value with a first and last name
+	int size() const;                       // Method to return the number of values
+	template <typename F> void forEach(F&& visit);  // Method to call visit on every value in number order
+	void printAll();                        // Method to print every value
+	void printFN(const string& first_name); // Method to print values with a first name
+	void flush();                           // Method to write the memtable out as a run now
+	int runCount();                         // Method to return the number of runs on disk
+
+	static void setMemtableLimit(int n);    // Method to set how many changes the memtable holds before flushing
+
+private:
+	static const int RUNS_BEFORE_COMPACT = 4;  // Runs that trigger a background merge
+	static int memtableLimit;               // Changes held before a flush
+
+	map<string, sortedRun::entry> memtable; // Recent changes by number; a removal is an entry flagged as a tombstone
+	vector<shared_ptr<sortedRun>> runs;     // Runs on disk, newest first
+	int count;                              // Number of live values
+	mutex runLock;                          // Guards runs against the compactor
+	thread compactor;                       // Background merge, if one has been started
+	atomic<bool> compacting;                // True while the compactor runs
+
+	bool lookup(const string& number, person& out);  // Method to find the newest state of a number, true if live
+	void startCompaction();                 // Method to merge the current runs in the background
+	template <typename F> static void mergeNewest(const vector<sortedRun::entry>& recent, const vector<shared_ptr<sortedRun>>& from, F&& visit);  // Method to visit the newest entry per number across sources
+};
+
+int lsmBucket::memtableLimit = 4096;
+
+// Constructor for the bucket
+lsmBucket::lsmBucket() : count(0), compacting(false) {}
+
+// Copy constructor for the bucket
+lsmBucket::lsmBucket(const lsmBucket& other) : memtable(other.memtable), count(other.count), compacting(false) {
+	lock_guard<mutex> hold(const_cast<mutex&>(other.runLock));  // A compactor may be swapping other's runs
+	runs = other.runs;
+}
+
+// Move constructor for the bucket
+lsmBucket::lsmBucket(lsmBucket&& other) noexcept : compacting(false) {
+	if (other.compactor.joinable()) other.compactor.join();  // Runs must not change while they are taken
+	memtable = std::move(other.memtable);
+	runs = std::move(other.runs);
+	count = other.count;
+	other.count = 0;
+}
+
+// Assignment operator for the bucket (copy-and-swap)
+lsmBucket& lsmBucket::operator=(lsmBucket other) {
+	if (compactor.joinable()) compactor.join();
+	swap(memtable, other.memtable);
+	swap(runs, other.runs);
+	swap(count, other.count);
+	return *this;
+}
+
+// Destructor for the bucket
+lsmBucket::~lsmBucket() {
+	if (compactor.joinable()) compactor.join();
+}
+
+// Public method to set the memtable size for every bucket
+void lsmBucket::setMemtableLimit(int n) {
+	memtableLimit = max(n, 1);
+}
+
+// Private method to find the newest state of a number: memtable first, then runs from newest to oldest
+bool lsmBucket::lookup(const string& number, person& out) {
+	auto recent = memtable.find(number);
+	if (recent != memtable.end()) {
+		out = recent->second.p;
+		return !recent->second.tombstone;
+	}
+
+	vector<shared_ptr<sortedRun>> snapshot;  // Held so a finishing compaction cannot free a run mid-lookup
+	{
+		lock_guard<mutex> hold(runLock);
+		snapshot = runs;
+	}
+	sortedRun::entry e;
+	pair<uint64_t, uint64_t> h = bloomFilter::hashes(number);  // Hashed once for every run's filter
+	for (const shared_ptr<sortedRun>& run : snapshot) {
+		if (run->find(number, h, e)) {
+			out = e.p;
+			return !e.tombstone;
+		}
+	}
+	return false;
+}
+
+// Public method to insert a value
+bool lsmBucket::insert(person v) {
+	person existing;
+	if (lookup(v.number, existing)) {
+		cout << "Already present, no insert." << endl;
+		return false;
+	}
+	sortedRun::entry& e = memtable[v.number];  // Replaces a tombstone left in the memtable
+	e = { std::move(v), false };
+	count++;
+	if ((int)memtable.size() >= memtableLimit) flush();
+	return true;
+}
+
+// Public method to retrieve a value by number
+person lsmBucket::retrieve(const string& v) {
+	person p;
+	return lookup(v, p) ? p : person();
+}
+
+// Public method to remove a value by number
+void lsmBucket::remove(const string& v) {
+	if (!erase(person("NONE", "NONE", v))) cout << "Node not found!" << endl;
+}
+
+// Public method to remove the value with p's number; older runs may still hold it, so a tombstone takes its place
+bool lsmBucket::erase(const person& p) {
+	person existing;
+	if (!lookup(p.number, existing)) return false;
+	memtable[p.number] = { person("", "", p.number), true };
+	count--;
+	if ((int)memtable.size() >= memtableLimit) flush();
+	return true;
+}
+
+// Public method to remove every value with the given first and last name
+void lsmBucket::removeFL(const string& fn, const string& ln) {
+	vector<string> numbers;  // Collect first, then remove
+	forEach([&](const person& p) { if (p.first_name == fn && p.last_name == ln) numbers.push_back(p.number); });
+	for (const string& n : numbers) erase(person(fn, ln, n));
+}
+
+// Public method to return the number of values
+int lsmBucket::size() const {
+	return count;
+}
+
+// Public method to write the memtable out as the newest run
+void lsmBucket::flush() {
+	if (!memtable.size()) return;
+	vector<sortedRun::entry> sorted;  // Memtable in number order
+	for (const auto& [number, e] : memtable) sorted.push_back(e);
+	shared_ptr<sortedRun> run = make_shared<sortedRun>(sorted);
+	memtable.clear();
+
+	{
+		lock_guard<mutex> hold(runLock);
+		runs.insert(runs.begin(), run);
+	}
+	if (!compacting) startCompaction();
+}
+
+// Public method to return the number of runs
+int lsmBucket::runCount() {
+	lock_guard<mutex> hold(runLock);
+	return runs.size();
+}
+
+// Private method to start a background merge if RUNS_BEFORE_COMPACT neighbouring runs have reached the same size tier
+// (tiers grow fourfold from the memtable size), so each entry is rewritten about once per tier rather than once per
+// flush. Runs flushed meanwhile sit in front of the chosen ones; the merged run takes the place of the ones it replaced.
+void lsmBucket::startCompaction() {
+	auto tier = [](int size) {
+		int t = 0;
+		for (long long s = memtableLimit; s * 4 <= size; s *= 4) t++;
+		return t;
+	};
+	vector<shared_ptr<sortedRun>> from;  // Runs to merge, newest first
+	bool oldest = false;                 // True if from ends with the oldest run
+	{
+		lock_guard<mutex> hold(runLock);
+		for (size_t i = 0, j; i < runs.size(); i = j) {  // Newest group first
+			for (j = i; j < runs.size() && tier(runs[j]->size()) == tier(runs[i]->size()); j++);
+			if (j - i >= (size_t)RUNS_BEFORE_COMPACT) {
+				from.assign(runs.begin() + i, runs.begin() + j);
+				oldest = j == runs.size();
+				break;
+			}
+		}
+	}
+	if (from.empty()) return;
+
+	if (compactor.joinable()) compactor.join();  // The last one has finished
+	compacting = true;
+	compactor = thread([this, from, oldest]() {
+		vector<sortedRun::entry> kept;  // With the oldest run included nothing older can hide behind a tombstone, so drop them
+		mergeNewest({}, from, [&](const sortedRun::entry& e) { if (!oldest || !e.tombstone) kept.push_back(e); });
+		shared_ptr<sortedRun> merged = make_shared<sortedRun>(kept);
+		{
+			lock_guard<mutex> hold(runLock);
+			auto at = find(runs.begin(), runs.end(), from[0]);  // The chosen runs are still together, in order
+			at = runs.erase(at, at + from.size());
+			if (merged->size()) runs.insert(at, merged);
+		}
+		compacting = false;
+	});
+}
+
+// Private method to merge sorted sources in one pass: recent (the memtable) and then from, newest first.
+// Each number is visited once, in order, with the entry from the newest source that has it; tombstones included.
+template <typename F>
+void lsmBucket::mergeNewest(const vector<sortedRun::entry>& recent, const vector<shared_ptr<sortedRun>>& from, F&& visit) {
+	vector<sortedRun::cursor> cur;  // One cursor per run, in the same order
+	for (const shared_ptr<sortedRun>& run : from) cur.emplace_back(*run);
+	size_t r = 0;                   // Position in recent
+
+	while (true) {
+		const string* low = r < recent.size() ? &recent[r].p.number : nullptr;  // Smallest number at the front of any source
+		for (const sortedRun::cursor& c : cur) {
+			if (c.valid && (!low || c.cur.p.number < *low)) low = &c.cur.p.number;
+		}
+		if (!low) return;
+		string number = *low;
+
+		const sortedRun::entry* win = nullptr;  // First source in age order with this number
+		if (r < recent.size() && recent[r].p.number == number) win = &recent[r];
+		for (const sortedRun::cursor& c : cur) {
+			if (!win && c.valid && c.cur.p.number == number) win = &c.cur;
+		}
+		visit(*win);
+
+		if (r < recent.size() && recent[r].p.number == number) r++;  // Every source moves past the number
+		for (sortedRun::cursor& c : cur) {
+			if (c.valid && c.cur.p.number == number) c.next();
+		}
+	}
+}
+
+// Public method to visit every live value in number order, merging the memtable and runs; the newest entry wins
+template <typename F>
+void lsmBucket::forEach(F&& visit) {
+	vector<shared_ptr<sortedRun>> snapshot;
+	{
+		lock_guard<mutex> hold(runLock);
+		snapshot = runs;
+	}
+	vector<sortedRun::entry> recent;  // Memtable in number order
+	for (const auto& [number, e] : memtable) recent.push_back(e);
+	vector<person> live;  // Collected first, so visit may change this bucket
+	mergeNewest(recent, snapshot, [&](const sortedRun::entry& e) { if (!e.tombstone) live.push_back(e.p); });
+	for (const person& p : live) visit(p);
+}
+
+// Public method to print every value
+void lsmBucket::printAll() {
+	forEach([](const person& p) { cout << p.first_name << ' ' << p.last_name << " : " << p.number << " || "; });
+}
+
+void lsmBucket::printFN(const string& first_name) {
+	forEach([&](const person& p) { if (p.first_name == first_name) cout << p.first_name << ' ' << p.last_name << " : " << p.number << " || "; });
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Read-only sorted name store. Names are front coded in blocks of BLOCK: the first name of a block is kept whole and
+// each later one as (length shared with the name before it, rest of the name). Neighbouring sorted names share long
+// prefixes, so this takes a fraction of the memory of separate strings. A block index of offsets lets lookups binary
+// search the block heads and then decode at most one block.
+class frontCodedNames {
+public:
+	static const int BLOCK = 16;            // Names per block
+
+	frontCodedNames(vector<string> names = {});  // Constructor; sorts names and drops repeats
+	int size() const;                       // Method to return the number of names
+	string at(int id) const;                // Method to return the id-th name in sorted order
+	int find(const string& name) const;     // Method to return the id of a name, -1 if absent
+	int lowerBound(const string& name, string* found = nullptr) const;  // Method to return the id of the first name not below name (size() if none), storing that name in *found if asked
+	template <typename F> void forEach(F&& visit, int from = 0) const;  // Method to call visit(id, name) for each name from id `from` on, decoding as it goes
+	size_t memoryUsed() const;              // Method to return the bytes held, index included
+
+private:
+	string bytes;                           // Encoded blocks, back to back
+	vector<uint32_t> blockAt;               // Offset of each block in bytes
+	int count;                              // Number of names
+
+	static void putVarint(string& out, uint32_t v);  // Method to append v, 7 bits per byte
+	static uint32_t getVarint(const string& in, size_t& pos);  // Method to read a varint at pos and move past it
+	string_view head(int block) const;      // Method to return a block's first name without copying it
+	template <typename F> void decodeBlock(int block, F&& visit) const;  // Method to call visit(id, name) for each name in one block
+};
+
+// Constructor for the store
+frontCodedNames::frontCodedNames(vector<string> names) {
+	sort(names.begin(), names.end());
+	names.erase(unique(names.begin(), names.end()), names.end());
+	count = names.size();
+	for (int i = 0; i < count; i++) {
+		if (i % BLOCK == 0) {  // Block head: whole name
+			blockAt.push_back(bytes.size());
+			putVarint(bytes, names[i].size());
+			bytes += names[i];
+			continue;
+		}
+		const string& prev = names[i - 1];
+		size_t shared = 0;
+		while (shared < prev.size() && shared < names[i].size() && prev[shared] == names[i][shared]) shared++;
+		putVarint(bytes, shared);
+		putVarint(bytes, names[i].size() - shared);
+		bytes.append(names[i], shared, string::npos);
+	}
+	bytes.shrink_to_fit();
+	blockAt.shrink_to_fit();
+}
+
+// Private method to append a varint
+void frontCodedNames::putVarint(string& out, uint32_t v) {
+	while (v >= 0x80) {
+		out += (char)(v | 0x80);
+		v >>= 7;
+	}
+	out += (char)v;
+}
+
+// Private method to read a varint
+uint32_t frontCodedNames::getVarint(const string& in, size_t& pos) {
+	uint32_t v = 0;
+	for (int shift = 0; ; shift += 7) {
+		unsigned char b = in[pos++];
+		v |= (uint32_t)(b & 0x7f) << shift;
+		if (!(b & 0x80)) return v;
+	}
+}
+
+// Private method to view a block's head
+string_view frontCodedNames::head(int block) const {
+	size_t pos = blockAt[block];
+	uint32_t len = getVarint(bytes, pos);
+	return string_view(bytes).substr(pos, len);
+}
+
+// Public method to return the number of names
+int frontCodedNames::size() const {
+	return count;
+}
+
+// Public method to decode one name: start at its block's head and apply the entries before it
+string frontCodedNames::at(int id) const {
+	string name;
+	if (id < 0 || id >= count) return name;
+	decodeBlock(id / BLOCK, [&](int i, const string& n) { if (i == id) name = n; });
+	return name;
+}
+
+// Public method to find the first name not below the given one
+int frontCodedNames::lowerBound(const string& name, string* found) const {
+	int lo = 0, hi = blockAt.size();  // Find the last block whose head is not above name
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+		if (head(mid) <= name) lo = mid + 1;
+		else hi = mid;
+	}
+	if (lo == 0) {  // Every name is above it
+		if (found && count) *found = head(0);
+		return 0;
+	}
+
+	int id = count;  // Decode only that block
+	int block = lo - 1;
+	decodeBlock(block, [&](int i, const string& n) {
+		if (id != count || n < name) return;
+		id = i;
+		if (found) *found = n;
+	});
+	if (id == count) {  // Past this block: the next head, if any
+		id = min((block + 1) * BLOCK, count);
+		if (found && id < count) *found = head(block + 1);
+	}
+	return id;
+}
+
+// Public method to find a name; the block lowerBound decodes is the only one decoded
+int frontCodedNames::find(const string& name) const {
+	string candidate;
+	int id = lowerBound(name, &candidate);
+	return id < count && candidate == name ? id : -1;
+}
+
+// Private method to decode one block, each name rebuilt from the one before it
+template <typename F>
+void frontCodedNames::decodeBlock(int block, F&& visit) const {
+	string name;
+	size_t pos = blockAt[block];
+	for (int i = block * BLOCK; i < count && i < (block + 1) * BLOCK; i++) {
+		uint32_t shared = i % BLOCK ? getVarint(bytes, pos) : 0;  // Heads share nothing
+		uint32_t len = getVarint(bytes, pos);
+		name.resize(shared);
+		name.append(bytes, pos, len);
+		pos += len;
+		visit(i, name);
+	}
+}
+
+// Public method to visit names in order; decoding starts at the block holding `from`
+template <typename F>
+void frontCodedNames::forEach(F&& visit, int from) const {
+	for (int block = max(from, 0) / BLOCK; block < (int)blockAt.size(); block++) {
+		decodeBlock(block, [&](int i, const string& name) { if (i >= from) visit(i, name); });
+	}
+}
+
+// Public method to return the memory held
+size_t frontCodedNames::memoryUsed() const {
+	return sizeof(*this) + bytes.capacity() + blockAt.capacity() * sizeof(uint32_t);
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Static symbol-table string compression in the style of FSST. Up to 255 symbols of 1 to 8 bytes each get a one-byte
+// code; bytes no symbol covers are written as ESCAPE then the byte. Every string is encoded by the same greedy
+// longest-match rule, so equal strings give equal codes and can be compared without decompressing.
+class symbolTable {
+public:
+	static const int MAX_SYMBOLS = 255;     // Codes 0..254 name symbols
+	static const unsigned char ESCAPE = 255;  // Next byte is a literal
+
+	void train(const vector<string>& sample);  // Method to build the symbols that best shrink the sample
+	string compress(string_view s) const;   // Method to encode a string
+	string decompress(string_view code) const;  // Method to decode a string
+	int symbols() const;                    // Method to return the number of symbols
+
+private:
+	static const int MAX_LEN = 8;           // Longest symbol
+	static const int ROUNDS = 5;            // Training rounds; each can double symbol lengths
+
+	vector<string> table;                   // Symbol for each code
+	vector<uint8_t> byFirst[256];           // Codes of the symbols starting with each byte, longest first
+
+	int match(const char* s, size_t left) const;  // Method to return the code of the longest symbol at s, -1 if none
+	void index();                           // Method to rebuild byFirst from table
+};
+
+// Private method to index the symbols by first byte
+void symbolTable::index() {
+	for (vector<uint8_t>& codes : byFirst) codes.clear();
+	for (int code = 0; code < (int)table.size(); code++) byFirst[(unsigned char)table[code][0]].push_back(code);
+	for (vector<uint8_t>& codes : byFirst) {
+		stable_sort(codes.begin(), codes.end(), [&](uint8_t a, uint8_t b) { return table[a].size() > table[b].size(); });
+	}
+}
+
+// Private method to find the longest symbol at s
+int symbolTable::match(const char* s, size_t left) const {
+	for (uint8_t code : byFirst[(unsigned char)*s]) {
+		const string& sym = table[code];
+		if (sym.size() <= left && memcmp(sym.data(), s, sym.size()) == 0) return code;
+	}
+	return -1;
+}
+
+// Public method to train on a sample. Each round encodes the sample with the current symbols, credits every symbol
+// used and every pair of neighbours (joined, up to MAX_LEN bytes) with the bytes they would cover, and keeps the
+// MAX_SYMBOLS candidates that cover the most.
+void symbolTable::train(const vector<string>& sample) {
+	table.clear();
+	index();
+	for (int round = 0; round < ROUNDS; round++) {
+		unordered_map<string, long long> gain;  // Bytes each candidate would cover
+		for (const string& s : sample) {
+			string prev;  // Previous symbol or literal
+			for (size_t pos = 0; pos < s.size(); ) {
+				int code = match(s.data() + pos, s.size() - pos);
+				string cur = code >= 0 ? table[code] : string(1, s[pos]);
+				gain[cur] += cur.size();
+				if (!prev.empty()) {
+					string joined = (prev + cur).substr(0, MAX_LEN);
+					gain[joined] += joined.size();
+				}
+				prev = cur;
+				pos += cur.size();
+			}
+		}
+		vector<pair<long long, string>> ranked;
+		for (auto& [sym, g] : gain) ranked.emplace_back(-g, sym);  // Most gain first, ties by bytes so training is repeatable
+		sort(ranked.begin(), ranked.end());
+		table.clear();
+		for (size_t i = 0; i < ranked.size() && (int)i < MAX_SYMBOLS; i++) table.push_back(ranked[i].second);
+		index();
+	}
+}
+
+// Public method to encode a string
+string symbolTable::compress(string_view s) const {
+	string out;
+	for (size_t pos = 0; pos < s.size(); ) {
+		int code = match(s.data() + pos, s.size() - pos);
+		if (code >= 0) {
+			out += (char)code;
+			pos += table[code].size();
+		}
+		else {
+			out += (char)ESCAPE;
+			out += s[pos++];
+		}
+	}
+	return out;
+}
+
+// Public method to decode a string
+string symbolTable::decompress(string_view code) const {
+	string out;
+	for (size_t pos = 0; pos < code.size(); pos++) {
+		unsigned char c = code[pos];
+		if (c == ESCAPE) out += code[++pos];
+		else out += table[c];
+	}
+	return out;
+}
+
+// Public method to return the number of symbols
+int symbolTable::symbols() const {
+	return table.size();
+}
+
+// People stored as compressed records in one byte arena: each field's code with its length in front, so any single
+// field can be decompressed on its own. Ids are kept in number order in an index, so lookups compress the key once
+// and binary search on the compressed numbers (equal numbers have equal codes). The symbol table may be shared by
+// several stores, which is how the tiered bucket's cold tiers use it.
+class compressedPeople {
+public:
+	enum fieldId { NUMBER, FIRST, LAST };   // Order of the fields within a record
+
+	compressedPeople(const vector<person>& sample);  // Constructor; trains its own symbol table on the sample's fields
+	compressedPeople(shared_ptr<const symbolTable> shared);  // Constructor; uses a symbol table trained elsewhere
+	int add(const person& p);               // Method to store a person, returns its id (-1 if a field's code needs 256 bytes or more)
+	void remove(const vector<int>& ids);    // Method to drop people by id (ascending) in one pass; the rest keep their order, renumbered from 0
+	string field(int id, fieldId f) const;  // Method to decompress one field of one person
+	person get(int id) const;               // Method to decompress a whole person
+	int findNumber(const string& number) const;  // Method to return the id of the person with a number, -1 if none (O(log n))
+	int size() const;                       // Method to return the number of people
+	size_t memoryUsed() const;              // Method to return the bytes held, index included
+	const symbolTable& symbols() const;     // Method to return the symbol table
+
+private:
+	shared_ptr<const symbolTable> table;    // Shared by every field
+	string arena;                           // Records, back to back
+	vector<uint32_t> start;                 // Offset of each record, plus the end
+	vector<uint32_t> byNumber;              // Ids sorted by compressed number
+
+	string_view code(int id, fieldId f) const;  // Method to view a field's compressed bytes
+	int lowerBound(string_view key) const;  // Method to return the index position of the first number code not below key
+};
+
+// Constructor for a store with its own symbol table
+compressedPeople::compressedPeople(const vector<person>& sample) : start(1, 0) {
+	vector<string> fields;
+	for (const person& p : sample) {
+		fields.push_back(p.first_name);
+		fields.push_back(p.last_name);
+		fields.push_back(p.number);
+	}
+	shared_ptr<symbolTable> own = make_shared<symbolTable>();
+	own->train(fields);
+	table = own;
+}
+
+// Constructor for a store sharing a symbol table
+compressedPeople::compressedPeople(shared_ptr<const symbolTable> shared) : table(std::move(shared)), start(1, 0) {}
+
+// Private method to binary search the index on compressed numbers
+int compressedPeople::lowerBound(string_view key) const {
+	return lower_bound(byNumber.begin(), byNumber.end(), key, [&](uint32_t id, string_view k) { return code(id, NUMBER) < k; }) - byNumber.begin();
+}
+
+// Public method to store a person; the index takes it at its number's place
+int compressedPeople::add(const person& p) {
+	string record;
+	for (const string* f : { &p.number, &p.first_name, &p.last_name }) {
+		string c = table->compress(*f);
+		if (c.size() > UINT8_MAX) return -1;
+		record += (char)c.size();
+		record += c;
+	}
+	int id = size();
+	arena += record;
+	start.push_back(arena.size());
+	byNumber.insert(byNumber.begin() + lowerBound(code(id, NUMBER)), id);
+	return id;
+}
+
+// Public method to drop people, compacting the arena and renumbering the index in one pass each
+void compressedPeople::remove(const vector<int>& ids) {
+	if (ids.empty()) return;
+	vector<int> renumbered(size());         // New id of each old id, -1 if dropped
+	string bytes;
+	vector<uint32_t> at(1, 0);
+	size_t d = 0;                           // Next dropped id
+	for (int id = 0; id < size(); id++) {
+		if (d < ids.size() && ids[d] == id) {
+			d++;
+			renumbered[id] = -1;
+			continue;
+		}
+		renumbered[id] = at.size() - 1;
+		bytes.append(arena, start[id], start[id + 1] - start[id]);
+		at.push_back(bytes.size());
+	}
+	vector<uint32_t> index;                 // Still in number order
+	index.reserve(at.size() - 1);
+	for (uint32_t id : byNumber) {
+		if (renumbered[id] >= 0) index.push_back(renumbered[id]);
+	}
+	bytes.shrink_to_fit();
+	arena = std::move(bytes);
+	start = std::move(at);
+	byNumber = std::move(index);
+}
+
+// Private method to view a field's compressed bytes, stepping over the fields before it
+string_view compressedPeople::code(int id, fieldId f) const {
+	size_t pos = start[id];
+	for (int k = 0; k < f; k++) pos += 1 + (unsigned char)arena[pos];
+	return string_view(arena).substr(pos + 1, (unsigned char)arena[pos]);
+}
+
+// Public method to decompress one field
+string compressedPeople::field(int id, fieldId f) const {
+	return table->decompress(code(id, f));
+}
+
+// Public method to decompress a person
+person compressedPeople::get(int id) const {
+	return person(field(id, FIRST), field(id, LAST), field(id, NUMBER));
+}
+
+// Public method to find a number by comparing compressed bytes
+int compressedPeople::findNumber(const string& number) const {
+	if (byNumber.empty()) return -1;
+	string key = table->compress(number);
+	int i = lowerBound(key);
+	return i < (int)byNumber.size() && code(byNumber[i], NUMBER) == key ? byNumber[i] : -1;
+}
+
+// Public method to return the number of people
+int compressedPeople::size() const {
+	return start.size() - 1;
+}
+
+// Public method to return the memory held by the records and index (the symbol table is under 2 KB and not counted)
+size_t compressedPeople::memoryUsed() const {
+	return arena.capacity() + (start.capacity() + byNumber.capacity()) * sizeof(uint32_t);
+}
+
+// Public method to return the symbol table
+const symbolTable& compressedPeople::symbols() const {
+	return *table;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Hot/cold tiered bucket. Recently used people stay as plain strings in an array sorted by number; the rest live in a
+// compressedPeople store sharing one symbol table across buckets. Lookups see both tiers, so callers going through
+// hashTable::retrieve and then this bucket's retrieve cannot tell which tier answered. Each tier keeps a one-byte
+// counter per value alongside it; every SAMPLE_EVERY-th lookup bumps the counter of the value it found, and every
+// TIER_EVERY lookups the counters decide who moves tier, and then all of them are halved.
+class tieredBucket {
+public:
+	tieredBucket();                         // Constructor
+
+	bool insert(person v);                  // Method to insert a value (into the hot tier), true if it was added
+	person retrieve(const string& v);       // Method to retrieve a value by number from either tier
+	void remove(const string& v);           // Method to remove a value by number
+	bool erase(const person& p);            // Method to remove the value with p's number, true if it was removed
+	void removeFL(const string& fn, const string& ln);  // Method to remove every value with a first and last name
+	int size() const;                       // Method to return the number of values
+	int hotCount() const;                   // Method to return the number of values in the hot tier
+	template <typename F> void forEach(F&& visit);  // Method to call visit on every value (hot tier in number order, then cold)
+	void printAll();                        // Method to print every value
+	void printFN(const string& first_name); // Method to print values with a first name
+	void retier();                          // Method to move people between tiers by their counters now
+	size_t hotBytes() const;                // Method to return the bytes held by the hot tier, counters included
+	size_t coldBytes() const;               // Method to return the bytes held by the cold tier, counters included
+
+	static void trainCold(const vector<string>& sample);  // Method to train the shared cold-tier symbols; call before any bucket demotes
+
+private:
+	static const int SAMPLE_EVERY = 4;      // Lookups per counted lookup
+	static const int TIER_EVERY = 1024;     // Lookups between tier moves
+	static const int HOT_AT = 2;            // Counter at which a cold value is promoted
+	static shared_ptr<symbolTable> codes;   // Shared by every bucket's cold tier
+
+	vector<person> hot;                     // Hot tier, sorted by number
+	vector<uint8_t> hotHeat;                // Sampled lookup counter of each hot value
+	compressedPeople cold;                  // Cold tier
+	vector<uint8_t> coldHeat;               // Sampled lookup counter of each cold person, by id
+	int lookups;                            // Lookups since the last tier move
+
+	static void warm(uint8_t& h);           // Method to bump a counter, saturating
+	int hotFind(const string& number) const;  // Method to return the index of the first hot value not below number
+	void dropCold(const vector<int>& ids);  // Method to remove cold people by id (ascending) with their counters
+};
+
+shared_ptr<symbolTable> tieredBucket::codes = make_shared<symbolTable>();
+
+// Constructor for the bucket
+tieredBucket::tieredBucket() : cold(codes), lookups(0) {}
+
+// Public method to train the cold-tier symbols. People already cold were coded with the old symbols, so this must
+// happen before any bucket demotes.
+void tieredBucket::trainCold(const vector<string>& sample) {
+	codes->train(sample);
+}
+
+// Private method to bump a counter
+void tieredBucket::warm(uint8_t& h) {
+	if (h < UINT8_MAX) h++;
+}
+
+// Private method to binary search the hot tier
+int tieredBucket::hotFind(const string& number) const {
+	return lower_bound(hot.begin(), hot.end(), number, [](const person& p, const string& n) { return p.number < n; }) - hot.begin();
+}
+
+// Private method to remove cold people; their counters go in the same pass
+void tieredBucket::dropCold(const vector<int>& ids) {
+	cold.remove(ids);
+	size_t d = 0, kept = 0;
+	for (size_t i = 0; i < coldHeat.size(); i++) {
+		if (d < ids.size() && ids[d] == (int)i) d++;
+		else coldHeat[kept++] = coldHeat[i];
+	}
+	coldHeat.resize(kept);
+}
+
+// Public method to insert a value; new people start hot, with a little heat so they are not demoted at once
+bool tieredBucket::insert(person v) {
+	int i = hotFind(v.number);
+	if ((i < (int)hot.size() && hot[i].number == v.number) || cold.findNumber(v.number) >= 0) {
+		cout << "Already present, no insert." << endl;
+		return false;
+	}
+	hot.insert(hot.begin() + i, std::move(v));
+	hotHeat.insert(hotHeat.begin() + i, 1);
+	return true;
+}
+
+// Public method to retrieve a value by number; a miss leaves no trace
+person tieredBucket::retrieve(const string& v) {
+	bool sampled = ++lookups % SAMPLE_EVERY == 0;
+	person p;
+	int i = hotFind(v);
+	if (i < (int)hot.size() && hot[i].number == v) {
+		p = hot[i];
+		if (sampled) warm(hotHeat[i]);
+	}
+	else if ((i = cold.findNumber(v)) >= 0) {  // Not hot; try cold
+		p = cold.get(i);
+		if (sampled) warm(coldHeat[i]);
+	}
+	if (lookups >= TIER_EVERY && lookups >= size()) retier();  // At least one lookup per value between passes
+	return p;
+}
+
+// Public method to remove a value by number
+void tieredBucket::remove(const string& v) {
+	if (!erase(person("NONE", "NONE", v))) cout << "Node not found!" << endl;
+}
+
+// Public method to remove the value with p's number; removing a cold value compacts the cold tier
+bool tieredBucket::erase(const person& p) {
+	int i = hotFind(p.number);
+	if (i < (int)hot.size() && hot[i].number == p.number) {
+		hot.erase(hot.begin() + i);
+		hotHeat.erase(hotHeat.begin() + i);
+		return true;
+	}
+	i = cold.findNumber(p.number);
+	if (i < 0) return false;
+	dropCold({ i });
+	return true;
+}
+
+// Public method to remove every value with the given first and last name
+void tieredBucket::removeFL(const string& fn, const string& ln) {
+	vector<string> numbers;  // Collect first, then remove
+	forEach([&](const person& p) { if (p.first_name == fn && p.last_name == ln) numbers.push_back(p.number); });
+	for (const string& n : numbers) erase(person(fn, ln, n));
+}
+
+// Public method to return the number of values
+int tieredBucket::size() const {
+	return hot.size() + cold.size();
+}
+
+// Public method to return the number of hot values
+int tieredBucket::hotCount() const {
+	return hot.size();
+}
+
+// Public method to return the bytes held by the hot tier (names and numbers fit in the strings themselves)
+size_t tieredBucket::hotBytes() const {
+	return hot.capacity() * sizeof(person) + hotHeat.capacity();
+}
+
+// Public method to return the bytes held by the cold tier
+size_t tieredBucket::coldBytes() const {
+	return cold.memoryUsed() + coldHeat.capacity();
+}
+
+// Public method to move people between tiers: hot values whose counter is zero go cold, cold values counted at least
+// HOT_AT times come back. Without trained symbols compression would only grow values, so they stay. The hot tier is
+// rebuilt in one merge pass and the cold tier compacted in one pass, so passes are spaced at least size() lookups apart.
+void tieredBucket::retier() {
+	lookups = 0;
+	if (!codes->symbols()) return;
+
+	vector<int> promote;  // Cold ids to bring back
+	vector<pair<person, uint8_t>> back;  // Their people and counters, sorted by number below
+	for (int i = 0; i < cold.size(); i++) {
+		if (coldHeat[i] < HOT_AT) continue;
+		promote.push_back(i);
+		back.emplace_back(cold.get(i), coldHeat[i]);
+	}
+	sort(back.begin(), back.end(), [](const pair<person, uint8_t>& a, const pair<person, uint8_t>& b) { return a.first.number < b.first.number; });
+
+	vector<person> keptHot;  // New hot tier: staying values merged with promoted ones
+	vector<uint8_t> keptHeat;
+	keptHot.reserve(hot.size() + back.size());
+	keptHeat.reserve(hot.size() + back.size());
+	size_t b = 0;
+	for (size_t i = 0; i <= hot.size(); i++) {
+		bool last = i == hot.size();  // One step past the end flushes the remaining promotions
+		while (b < back.size() && (last || back[b].first.number < hot[i].number)) {
+			keptHot.push_back(std::move(back[b].first));
+			keptHeat.push_back(back[b++].second);
+		}
+		if (last) break;
+		if (!hotHeat[i] && cold.add(hot[i]) >= 0) {  // Demoted; too long to pack stays hot
+			coldHeat.push_back(0);
+			continue;
+		}
+		keptHot.push_back(std::move(hot[i]));
+		keptHeat.push_back(hotHeat[i]);
+	}
+
+	dropCold(promote);  // Ids below the demoted ones, so appending first left them in place
+	hot = std::move(keptHot);
+	hotHeat = std::move(keptHeat);
+	for (uint8_t& h : hotHeat) h /= 2;  // Age every counter
+	for (uint8_t& h : coldHeat) h /= 2;
+}
+
+// Public method to visit every value
+template <typename F>
+void tieredBucket::forEach(F&& visit) {
+	for (const person& p : hot) visit(p);
+	for (int i = 0; i < cold.size(); i++) visit(cold.get(i));
+}
+
+// Public method to print every value
+void tieredBucket::printAll() {
+	forEach([](const person& p) { cout << p.first_name << ' ' << p.last_name << " : " << p.number << " || "; });
+}
+
+void tieredBucket::printFN(const string& first_name) {
+	forEach([&](const person& p) { if (p.first_name == first_name) cout << p.first_name << ' ' << p.last_name << " : " << p.number << " || "; });
+}
+
+// Hierarchical timing wheel that tells the directory when temporary contacts expire.
+// Level 0 has one slot per tick; each higher level's slot covers a whole turn of the level below,
+// and its entries are cascaded down as time reaches them, so each entry is touched O(LEVELS) times in total.
+class timingWheel {
+public:
+	timingWheel(long long start = 0);  // Constructor; start is the current tick
+
+	void schedule(const person& p, long long ttl);  // Method to expire p after ttl ticks
+	vector<person> advance(long long now);  // Method to move time forward to now and return everyone who expired
+	int size() const;  // Number of people still waiting to expire
+
+private:
+	static const int BITS = 6;              // log2 of the slots per level
+	static const int SLOTS = 1 << BITS;     // Slots per level
+	static const int LEVELS = 4;            // Levels; later expiries wait in the top level until they come in range
+
+	struct entry {
+		person p;        // Person to remove
+		long long due;   // Tick at which to remove them
+	};
+
+	vector<entry> wheel[LEVELS][SLOTS];  // Pending entries for each level and slot
+	long long current;  // Current tick
+	int pending;        // Number of scheduled entries
+
+	void place(entry e);  // Method to put an entry into the slot for its due tick
+};
+
+// Constructor for the timing wheel
+timingWheel::timingWheel(long long start) : current(start), pending(0) {}
+
+// Public method to schedule p for removal ttl ticks from now
+void timingWheel::schedule(const person& p, long long ttl) {
+	place({ p, current + (ttl > 0 ? ttl : 1) });  // Never schedule into a tick that has already passed
+	pending++;
+}
+
+// Method to put an entry into the lowest level whose range covers its due tick
+void timingWheel::place(entry e) {
+	long long delta = e.due - current;  // Ticks left until the entry is due
+	int level = 0;
+	while (level < LEVELS - 1 && delta >= (1LL << (BITS * (level + 1)))) level++;  // Find the lowest level that reaches that far
+
+	int slot = (e.due >> (BITS * level)) & (SLOTS - 1);  // Slot of the due tick at that level
+	wheel[level][slot].push_back(std::move(e));
+}
+
+// Public method to advance to tick now and return the expired batch
+vector<person> timingWheel::advance(long long now) {
+	vector<person> expired;  // Everyone whose tick came up
+	while (current < now && pending) {  // Stop early once nothing is waiting
+		current++;
+
+		for (int level = 1; level < LEVELS; level++) {  // Cascade higher levels whose slot just came into range
+			if (current & ((1LL << (BITS * level)) - 1)) break;  // Lower level has not wrapped, so nothing above it did either
+			vector<entry> moving;
+			moving.swap(wheel[level][(current >> (BITS * level)) & (SLOTS - 1)]);
+			for (entry& e : moving) place(std::move(e));  // Re-place each entry at a finer level
+		}
+
+		vector<entry> due;  // Entries in the current level 0 slot
+		due.swap(wheel[0][current & (SLOTS - 1)]);
+		for (entry& e : due) {
+			if (e.due <= current) {  // Its time has come
+				expired.push_back(std::move(e.p));
+				pending--;
+			}
+			else place(std::move(e));  // Far-future entry from the top level that needs another lap
+		}
+	}
+	if (current < now) current = now;  // Jump over the ticks where nothing was waiting
+	return expired;
+}
+
+// Public method to return the number of waiting entries
+int timingWheel::size() const {
+	return pending;
+}
+
+// Requirements on anything stored in a hashTable slot
+template <typename T>
+concept BucketContainer = std::default_initializable<T> && requires(T& bucket, string s) {
+	bucket.printAll();     // Must be able to print every element
+	bucket.printFN(s);     // Must be able to print elements with a given first name
+};
+
+// Key extraction policies: which field of a person a hashTable hashes on
+struct noKey {};  // Slots are only reachable through retrieve(); insert/erase are unavailable
+
+struct byFirstName {
+	static const string& key(const person& p) { return p.first_name; }  // Hash on the first name
+};
+
+struct byLastName {
+	static const string& key(const person& p) { return p.last_name; }   // Hash on the last name
+};
+
+// Requirements on a key extraction policy
+template <typename K>
+concept KeyExtractor = requires(const person& p) {
+	{ K::key(p) } -> std::convertible_to<const string&>;
+};
+
+// Buckets that can look a person up by number
+template <typename T>
+concept NumberLookup = requires(T& bucket, const string& s) {
+	{ bucket.retrieve(s) } -> std::same_as<person>;
+};
+
+// Buckets that can switch to lazy deletion
+template <typename T>
+concept LazyDeletable = requires(T& bucket) {
+	bucket.setLazyDelete(true, 0.25);
+};
+
+// Compile-time description of what a bucket can do beyond BucketContainer; specialize for new bucket types
+template <typename T>
+struct bucket_traits {
+	static constexpr bool is_ordered = false;       // In-order scans come out sorted by number, so batches are worth sorting first
+	static constexpr bool supports_batch = false;   // Has int insertBatch(vector<person>)
+	static constexpr bool supports_paging = false;  // Has int page(string& after, int n, visit), resuming after a number
+};
+
+template <>
+struct bucket_traits<AVL> {
+	static constexpr bool is_ordered = true;
+	static constexpr bool supports_batch = true;
+	static constexpr bool supports_paging = true;
+};
+
+template <>
+struct bucket_traits<treap> {
+	static constexpr bool is_ordered = true;
+	static constexpr bool supports_batch = false;
+	static constexpr bool supports_paging = false;
+};
+
+template <>
+struct bucket_traits<skipList> {
+	static constexpr bool is_ordered = true;
+	static constexpr bool supports_batch = false;
+	static constexpr bool supports_paging = false;
+};
+
+template <>
+struct bucket_traits<phoneBucket> {
+	static constexpr bool is_ordered = false;  // Numbers in an unusual form are visited after the rest
+	static constexpr bool supports_batch = false;
+	static constexpr bool supports_paging = false;
+};
+
+template <>
+struct bucket_traits<diskBucket> {
+	static constexpr bool is_ordered = true;
+	static constexpr bool supports_batch = false;
+	static constexpr bool supports_paging = false;
+};
+
+template <>
+struct bucket_traits<lsmBucket> {
+	static constexpr bool is_ordered = true;
+	static constexpr bool supports_batch = false;
+	static constexpr bool supports_paging = false;
+};
+
+template <>
+struct bucket_traits<tieredBucket> {
+	static constexpr bool is_ordered = false;  // Cold values are visited after the hot ones
+	static constexpr bool supports_batch = false;
+	static constexpr bool supports_paging = false;
+};
+
+template <typename T, int N>
+struct bucket_traits<StaticAVL<T, N>> {
+	static constexpr bool is_ordered = true;
+	static constexpr bool supports_batch = false;
+	static constexpr bool supports_paging = false;
+};
+
+// Resumable position in a scan of a (possibly nested) hashTable: a slot index per table level, outermost first,
+// then the last number visited in the innermost bucket. It stays valid across inserts and removals, but pages
+// taken across a resize may repeat or miss people, since slot indices change.
+struct scanCursor {
+	vector<int> slot;  // Slot index at each level
+	string key;        // Last number visited in the current bucket, "" before the first
+	bool done = false; // True once the scan has passed the last slot
+	bool valid = true; // False if decode was given text that encode could not have written; such a cursor pages nothing
+
+	string encode() const {  // Method to write the position as text, e.g. "3/5/469-220-8117", for a front-end to hand back later
+		string out;
+		for (int i : slot) out += to_string(i) + '/';
+		return out + key;
+	}
+
+	static scanCursor decode(const string& text) {  // Method to rebuild a position written by encode; the text comes from clients, so anything else gives an invalid cursor
+		scanCursor c;
+		size_t start = 0;
+		for (size_t end; (end = text.find('/', start)) != string::npos; start = end + 1) {
+			size_t len = end - start;
+			if (!len || len > 9 || text.find_first_not_of("0123456789", start) < end) {  // Slots are short runs of digits
+				c.slot.clear();
+				c.done = true;
+				c.valid = false;
+				return c;
+			}
+			c.slot.push_back(stoi(text.substr(start, len)));
+		}
+		c.key = text.substr(start);
+		return c;
+	}
+};
+
+template <BucketContainer cldManage, typename KeyOf = noKey>
+class hashTable {  // Template class definition for hashTable with a type parameter cldManage
+public:
+	hashTable(int expElementCT = 6);  // Constructor declaration with a default argument
+	hashTable(const hashTable& other);  // Copy constructor; shares buckets copy-on-write
+	hashTable(hashTable&& other) noexcept;  // Move constructor; the source is left empty and may only be destroyed or assigned
+	hashTable& operator=(hashTable other);  // Copy/move assignment
+	~hashTable();  // Destructor declaration
+
+	hashTable clone() const;  // Method to fork the table cheaply; buckets are copied only once one side changes them
+
+	cldManage& retrieve(const string& key);  // Method to retrieve an element based on its key
+	const cldManage* find(const string& key) const;  // Method to look up the element for a key without creating or unsharing it, nullptr if its slot is empty
+
+	// Insert/remove route through KeyOf, so they only exist when the table knows its key
+	bool insert(person p) requires KeyExtractor<KeyOf>;  // Method to insert a person, true if it was added
+	int insertBatch(vector<person> batch) requires KeyExtractor<KeyOf>;  // Method to insert many people, returns how many were added
+	vector<person> retrieveBatch(const vector<person>& probes) requires KeyExtractor<KeyOf> && NumberLookup<cldManage>;  // Method to look up many people by key and number; entry i is probe i's match, or an empty person
+	bool erase(const person& p) requires KeyExtractor<KeyOf>;  // Method to remove a person (matched by number), true if it was removed
+	int removeFL(const string& fn, const string& ln) requires KeyExtractor<KeyOf>;  // Method to remove everyone with a first and last name, returns how many were removed
+	void resize(int expElementCt) requires KeyExtractor<KeyOf>;  // Method to rebuild the table for a new expected key count
+	int expire(timingWheel& wheel, long long now) requires KeyExtractor<KeyOf>;  // Method to remove everyone the wheel says has expired by now
+
+	int size() const;  // Number of people inserted through insert/insertBatch
+	int slotsUsed() const;  // Number of slots holding an element
+	void setStats(directoryStats* s);  // Method to have insert/insertBatch record every added person in s (nullptr to stop)
+	void setNumberRegistry(numberRegistry* r);  // Method to have insert/insertBatch/erase keep r up to date (nullptr to stop)
+	void setBufferPool(bufferPool* p) requires std::constructible_from<cldManage, bufferPool*>;  // Method to put buckets created from now on in pool p (nullptr for the buckets' default)
+	void setLazyDelete(bool on, double threshold = 0.25) requires LazyDeletable<cldManage>;  // Method to switch lazy deletion on or off for every bucket, including ones created later
+	template <typename F> void forEach(F&& visit) const;  // Method to call visit on every person
+	template <typename F> void forEachBucket(F&& visit) const;  // Method to call visit on every allocated element, read only; elements shared with clones are not unshared
+	// Paging resumes inside a bucket from the last number visited, so it only exists when the buckets can do that
+	template <typename F> int page(scanCursor& c, int n, F&& visit) requires bucket_traits<cldManage>::supports_paging;  // Method to visit the next n people after cursor c and advance it; returns how many were visited
+	template <typename F> int pageFrom(scanCursor& c, int level, int n, F&& visit) requires bucket_traits<cldManage>::supports_paging;  // Method to page from this table's level of c; used by enclosing tables
+
+	void printAll();  // Method to print all elements; not typical for hash tables
+	void printFN(string first_name);  // Method to print elements based on the first name
+private:
+	shared_ptr<cldManage>* table;  // Array of pointers to cldManage elements; a slot stays empty until first used and may be shared with clones
+	int len;  // Length of the hash table
+	int used;  // Number of slots that have been allocated
+	int count;  // Number of people held, as reported by the buckets
+	directoryStats* stats;  // Sketches to update on insert, or nullptr
+	numberRegistry* numbers;  // Registry to check inserts against, or nullptr
+	bufferPool* pool;  // Pool for new buckets that keep pages, or nullptr
+	bool lazy;  // True if new buckets start in lazy-delete mode
+	double maxDead;  // Dead fraction new lazy buckets compact at
+
+	unsigned long long hash(const string& key) const;  // Method to compute the hash value for a given key
+	cldManage& slotAt(int index);  // Method to get the element at an index for writing, creating or unsharing it if needed
+};
+
+template <BucketContainer cldManage, typename KeyOf>
+struct bucket_traits<hashTable<cldManage, KeyOf>> {
+	static constexpr bool is_ordered = false;
+	static constexpr bool supports_batch = KeyExtractor<KeyOf>;
+	static constexpr bool supports_paging = bucket_traits<cldManage>::supports_paging;  // Pages through its slots if its buckets can resume
+};
+
+// Constructor definition for the hash table
+template <BucketContainer cldManage, typename KeyOf>
+hashTable<cldManage, KeyOf>::hashTable(int expElementCt) : used(0), count(0), stats(nullptr), numbers(nullptr), pool(nullptr), lazy(false), maxDead(0.25) {  // Constructor implementation
+	// Set tableLen to the next prime greater than expected number of books divided by 0.75
+	len = next_prime(expElementCt / 0.75 + 1);  // Calculate and assign the length of the hash table
+	table = new shared_ptr<cldManage>[len];  // Allocate empty slots only; each cldManage is built on first retrieve
+}
+
+template <BucketContainer cldManage, typename KeyOf>
+hashTable<cldManage, KeyOf>::hashTable(const hashTable& other) : len(other.len), used(other.used), count(other.count), stats(nullptr), numbers(nullptr), pool(other.pool), lazy(other.lazy), maxDead(other.maxDead) {  // Copy constructor implementation
+	table = new shared_ptr<cldManage>[len];  // Allocate a slot array of the same length
+	for (int i = 0; i < len; i++) {  // Loop through each index of the table
+		table[i] = other.table[i];  // Share the element instead of copying it
+	}
+}
+
+template <BucketContainer cldManage, typename KeyOf>
+hashTable<cldManage, KeyOf>::hashTable(hashTable&& other) noexcept : table(other.table), len(other.len), used(other.used), count(other.count), stats(other.stats), numbers(other.numbers), pool(other.pool), lazy(other.lazy), maxDead(other.maxDead) {  // Move constructor implementation
+	other.table = nullptr;  // The source no longer owns any slots
+	other.len = 0;
+	other.used = 0;
+	other.count = 0;
+}
+
+template <BucketContainer cldManage, typename KeyOf>
+hashTable<cldManage, KeyOf>& hashTable<cldManage, KeyOf>::operator=(hashTable other) {  // Assignment implementation (copy-and-swap)
+	swap(table, other.table);
+	swap(len, other.len);
+	swap(used, other.used);
+	swap(count, other.count);
+	swap(stats, other.stats);
+	swap(numbers, other.numbers);
+	swap(pool, other.pool);
+	swap(lazy, other.lazy);
+	swap(maxDead, other.maxDead);
+	return *this;  // other now owns and frees the old slots
+}
+
+template <BucketContainer cldManage, typename KeyOf>
+hashTable<cldManage, KeyOf>::~hashTable() {  // Destructor implementation
+	delete[] table;  // Deallocate the slots; each element is freed once no table shares it
+}
+
+template <BucketContainer cldManage, typename KeyOf>
+hashTable<cldManage, KeyOf> hashTable<cldManage, KeyOf>::clone() const {  // Method to fork the table
+	return hashTable(*this);  // The copy constructor only shares the slots
+}
+
+template <BucketContainer cldManage, typename KeyOf>
+cldManage& hashTable<cldManage, KeyOf>::slotAt(int index) {  // Method to get the element at an index for writing
+	shared_ptr<cldManage>& slot = table[index];  // Find the slot at the index
+	if (!slot) {  // Lazily create the element the first time its slot is used
+		if constexpr (std::constructible_from<cldManage, bufferPool*>) slot = make_shared<cldManage>(pool);  // In this table's pool, if it has one
+		else slot = make_shared<cldManage>();
+		if constexpr (LazyDeletable<cldManage>) {
+			if (lazy) slot->setLazyDelete(true, maxDead);  // Same deletion mode as the buckets already here
+		}
+		used++;
+	}
+	else if (slot.use_count() > 1) {  // Another table shares this element, so copy it before it changes
+		slot = make_shared<cldManage>(*slot);
+	}
+	return *slot;  // Return the element at the index
+}
+
+template <BucketContainer cldManage, typename KeyOf>
+cldManage& hashTable<cldManage, KeyOf>::retrieve(const string& key) {  // Method to retrieve an element by key
+	return slotAt(hash(key) % len);  // Return the element at the hashed index
+}
+
+template <BucketContainer cldManage, typename KeyOf>
+const cldManage* hashTable<cldManage, KeyOf>::find(const string& key) const {  // Method to look up an element without creating it
+	return table[hash(key) % len].get();  // Empty slots hold nullptr
+}
+
+template <BucketContainer cldManage, typename KeyOf>
+bool hashTable<cldManage, KeyOf>::insert(person p) requires KeyExtractor<KeyOf> {  // Method to insert a person
+	int index = hash(KeyOf::key(p)) % len;  // Slot the person hashes to
+	if (!table[index] && 4 * (used + 1) > 3 * len) {  // Grow before the slots get more than 75% used
+		resize(2 * used);
+		index = hash(KeyOf::key(p)) % len;
+	}
+
+	optional<person> seen;  // Copy for the sketches and registry, which only hear about people actually added
+	if (stats || numbers) seen = p;
+	if (!slotAt(index).insert(std::move(p))) return false;  // Hand the person to its bucket; a rejected duplicate changes nothing
+	count++;
+	if (stats) stats->add(*seen);
+	if (numbers) numbers->add(*seen);
+	return true;
+}
+
+template <BucketContainer cldManage, typename KeyOf>
+int hashTable<cldManage, KeyOf>::insertBatch(vector<person> batch) requires KeyExtractor<KeyOf> {  // Method to insert a batch
+	if (stats || numbers) {  // Buckets do not say which of a batch they kept, so record people one at a time
+		int added = 0;
+		for (person& p : batch) added += insert(std::move(p));
+		return added;
+	}
+
+	vector<unsigned long long> hashes(batch.size());  // Each person's key hash, reused for grouping after any resize
+	vector<unsigned long long> fresh;  // Hashes of keys whose slot is empty, so the key is certainly new
+	for (size_t i = 0; i < batch.size(); i++) {
+		hashes[i] = hash(KeyOf::key(batch[i]));
+		if (!table[hashes[i] % len]) fresh.push_back(hashes[i]);
+	}
+	sort(fresh.begin(), fresh.end());
+	fresh.erase(unique(fresh.begin(), fresh.end()), fresh.end());  // One entry per distinct new key
+	vector<bool> filling(len);  // Empty slots the batch would fill
+	int newSlots = 0;
+	for (unsigned long long h : fresh) {
+		if (filling[h % len]) continue;
+		filling[h % len] = true;
+		newSlots++;
+	}
+	if (4 * (used + newSlots) > 3 * len) resize(2 * (used + (int)fresh.size()));  // Same 75% rule as insert, grown once for all the new keys
+
+	vector<vector<person>> groups(len);  // People grouped by the slot they hash to
+	for (size_t i = 0; i < batch.size(); i++) {
+		groups[hashes[i] % len].push_back(std::move(batch[i]));
+	}
+
+	int added = 0;  // Number of people the buckets kept
+	for (int i = 0; i < len; i++) {  // Loop through each index of the table
+		if (groups[i].empty()) continue;  // Skip slots with nothing to insert
+		if constexpr (bucket_traits<cldManage>::supports_batch) {
+			added += slotAt(i).insertBatch(std::move(groups[i]));  // Let the bucket take its whole group at once
+		}
+		else {
+			if constexpr (bucket_traits<cldManage>::is_ordered) {  // Inserting in number order keeps each insert near the last one's path
+				stable_sort(groups[i].begin(), groups[i].end(), [](const person& a, const person& b) { return a.number < b.number; });
+			}
+			for (person& p : groups[i]) added += slotAt(i).insert(std::move(p));  // Fall back to one insert per person
+		}
+	}
+	count += added;
+	return added;
+}
+
+template <BucketContainer cldManage, typename KeyOf>
+vector<person> hashTable<cldManage, KeyOf>::retrieveBatch(const vector<person>& probes) requires KeyExtractor<KeyOf> && NumberLookup<cldManage> {  // Method to look up a batch
+	vector<vector<int>> groups(len);  // Probe indices grouped by the slot they hash to
+	for (int i = 0; i < (int)probes.size(); i++) groups[hash(KeyOf::key(probes[i])) % len].push_back(i);
+
+	vector<person> found(probes.size());  // Misses stay empty people
+	for (int i = 0; i < len; i++) {  // Loop through each index of the table
+		if (groups[i].empty() || !table[i]) continue;  // An empty slot holds none of its probes
+		if constexpr (bucket_traits<cldManage>::is_ordered) {  // Probing in number order walks each bucket front to back
+			sort(groups[i].begin(), groups[i].end(), [&](int a, int b) { return probes[a].number < probes[b].number; });
+		}
+		cldManage& bucket = slotAt(i);  // Lookups may update the bucket (e.g. tier heat), so unshare it once for the group
+		for (int j : groups[i]) found[j] = bucket.retrieve(probes[j].number);
+	}
+	return found;
+}
+
+template <BucketContainer cldManage, typename KeyOf>
+bool hashTable<cldManage, KeyOf>::erase(const person& p) requires KeyExtractor<KeyOf> {  // Method to remove a person
+	int index = hash(KeyOf::key(p)) % len;  // Slot the person hashes to
+	if (!table[index] || !slotAt(index).erase(p)) return false;  // Nothing to remove; only unshare slots that exist
+	count--;
+	if (numbers) numbers->remove(p);
+	return true;
+}
+
+template <BucketContainer cldManage, typename KeyOf>
+int hashTable<cldManage, KeyOf>::removeFL(const string& fn, const string& ln) requires KeyExtractor<KeyOf> {  // Method to remove everyone with a name
+	int index = hash(KeyOf::key(person(fn, ln))) % len;  // Everyone with the name hashes to the same slot
+	if (!table[index]) return 0;  // Nothing to remove; only unshare slots that exist
+	cldManage& bucket = slotAt(index);
+	vector<person> leaving;  // People the registry has to forget
+	if (numbers) bucket.forEach([&](const person& p) { if (p.first_name == fn && p.last_name == ln) leaving.push_back(p); });
+	int before = bucket.size();
+	bucket.removeFL(fn, ln);
+	int removed = before - bucket.size();
+	count -= removed;
+	for (const person& p : leaving) numbers->remove(p);
+	return removed;
+}
+
+template <BucketContainer cldManage, typename KeyOf>
+void hashTable<cldManage, KeyOf>::resize(int expElementCt) requires KeyExtractor<KeyOf> {  // Method to rebuild the table
+	hashTable fresh(expElementCt);  // Empty table of the new length
+	fresh.pool = pool;  // New buckets go in the same pool
+	fresh.lazy = lazy;  // And delete the same way
+	fresh.maxDead = maxDead;
+	forEach([&](const person& p) { fresh.slotAt(fresh.hash(KeyOf::key(p)) % fresh.len).insert(p); });  // Rehash every person
+
+	swap(table, fresh.table);  // Take over the new slots; fresh frees the old ones
+	swap(len, fresh.len);
+	swap(used, fresh.used);
+}
+
+template <BucketContainer cldManage, typename KeyOf>
+int hashTable<cldManage, KeyOf>::expire(timingWheel& wheel, long long now) requires KeyExtractor<KeyOf> {  // Method to remove expired people
+	int removed = 0;  // Number of people actually removed
+	for (const person& p : wheel.advance(now)) {  // Everyone due by now, in one batch
+		removed += erase(p);  // Matched by number; a person already removed by hand is not counted
+	}
+	return removed;
+}
+
+template <BucketContainer cldManage, typename KeyOf>
+int hashTable<cldManage, KeyOf>::size() const {  // Method to return the number of people
+	return count;
+}
+
+template <BucketContainer cldManage, typename KeyOf>
+void hashTable<cldManage, KeyOf>::setStats(directoryStats* s) {  // Method to attach distinct-count sketches
+	stats = s;
+}
+
+template <BucketContainer cldManage, typename KeyOf>
+void hashTable<cldManage, KeyOf>::setNumberRegistry(numberRegistry* r) {  // Method to attach a shared-number registry
+	numbers = r;
+}
+
+template <BucketContainer cldManage, typename KeyOf>
+void hashTable<cldManage, KeyOf>::setBufferPool(bufferPool* p) requires std::constructible_from<cldManage, bufferPool*> {  // Method to choose the pool for new buckets
+	pool = p;
+}
+
+template <BucketContainer cldManage, typename KeyOf>
+void hashTable<cldManage, KeyOf>::setLazyDelete(bool on, double threshold) requires LazyDeletable<cldManage> {  // Method to set the deletion mode of every bucket
+	lazy = on;
+	maxDead = threshold;
+	for (int i = 0; i < len; i++) {  // Loop through each index of the table
+		if (table[i]) slotAt(i).setLazyDelete(on, threshold);  // Existing buckets switch now; new ones in slotAt
+	}
+}
+
+template <BucketContainer cldManage, typename KeyOf>
+int hashTable<cldManage, KeyOf>::slotsUsed() const {  // Method to return the number of allocated slots
+	return used;
+}
+
+template <BucketContainer cldManage, typename KeyOf>
+template <typename F>
+void hashTable<cldManage, KeyOf>::forEach(F&& visit) const {  // Method to visit every person
+	for (int i = 0; i < len; i++) {  // Loop through each index of the table
+		if (table[i]) table[i]->forEach(visit);  // Visit each allocated cldManage element
+	}
+}
+
+template <BucketContainer cldManage, typename KeyOf>
+template <typename F>
+void hashTable<cldManage, KeyOf>::forEachBucket(F&& visit) const {  // Method to visit every allocated element
+	for (int i = 0; i < len; i++) {  // Loop through each index of the table
+		if (table[i]) visit((const cldManage&)*table[i]);  // Writes must go through slotAt, which unshares first
+	}
+}
+
+template <BucketContainer cldManage, typename KeyOf>
+template <typename F>
+int hashTable<cldManage, KeyOf>::page(scanCursor& c, int n, F&& visit) requires bucket_traits<cldManage>::supports_paging {  // Method to visit the next page of people
+	if (c.done) return 0;
+	int visited = pageFrom(c, 0, n, visit);
+	c.done = c.slot[0] >= len;  // Every slot has been drained
+	return visited;
+}
+
+template <BucketContainer cldManage, typename KeyOf>
+template <typename F>
+int hashTable<cldManage, KeyOf>::pageFrom(scanCursor& c, int level, int n, F&& visit) requires bucket_traits<cldManage>::supports_paging {  // Method to page from one level of the cursor
+	if ((int)c.slot.size() <= level) c.slot.resize(level + 1, 0);  // A fresh cursor starts at slot 0 of every level
+	if (c.slot[level] < 0) c.slot[level] = len;  // Not a slot of this table: nothing to resume here
+	int visited = 0;  // People visited on this page
+	for (; c.slot[level] < len; c.slot[level]++) {  // Resume at this level's slot; indexed each time, since nested levels may grow c.slot
+		shared_ptr<cldManage>& slot = table[c.slot[level]];
+		if (slot) {
+			if constexpr (requires { slot->pageFrom(c, level + 1, n, visit); }) {
+				visited += slot->pageFrom(c, level + 1, n - visited, visit);  // Nested table: it pages its own slots
+			}
+			else {
+				visited += slot->page(c.key, n - visited, visit);  // Bucket: resume after the last number visited
+			}
+			if (visited == n) return visited;  // Page filled; this slot may have more
+		}
+		c.slot.resize(level + 1);  // Moving to the next slot starts the levels below afresh
+		c.key.clear();
+	}
+	return visited;
+}
+
+template <BucketContainer cldManage, typename KeyOf>
+void hashTable<cldManage, KeyOf>::printAll() {  // Method to print all elements in the hash table
+	for (int i = 0; i < len; i++) {  // Loop through each index of the table
+		if (table[i]) table[i]->printAll();  // Call printAll on each allocated cldManage element
+	}
+}
+
+template <BucketContainer cldManage, typename KeyOf>
+void hashTable<cldManage, KeyOf>::printFN(string first_name) {  // Method to print elements by first name
+	for (int i = 0; i < len; i++) {  // Loop through each index of the table
+		if (table[i]) table[i]->printFN(first_name);  // Call printFN on each allocated cldManage element with the provided first name
+	}
+}
+
+template <BucketContainer cldManage, typename KeyOf>
+unsigned long long hashTable<cldManage, KeyOf>::hash(const string& key) const {  // Method to compute a hash value for a given key
+	return fnv1a(key);  // FNV-1a hash of the key
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Query planner for the directory (people hashed by first name, then by last name, into AVL buckets)
+
+// A conjunction of predicates; an empty field is unconstrained. Giving both names asks for a full name.
+struct query {
+	string first_name;    // Exact first name
+	string last_name;     // Exact last name
+	string numberPrefix;  // Leading characters of the number
+
+	bool matches(const person& p) const {  // Method to check every predicate against a person
+		return (first_name.empty() || p.first_name == first_name)
+			&& (last_name.empty() || p.last_name == last_name)
+			&& p.number.compare(0, numberPrefix.size(), numberPrefix) == 0;
+	}
+};
+
+// How a query will reach its people, and what the planner expects that to cost
+struct queryPlan {
+	enum accessPath { FULL_SCAN, BY_FIRST, BY_FULL_NAME, BY_LAST };
+	accessPath path;  // Chosen access path
+	double cost;      // Estimated people visited plus weighted bucket probes
+	double rows;      // Estimated number of matches
+
+	const char* name() const {  // Method to name the access path for printing
+		static const char* names[] = { "full scan", "first-name index", "full-name index", "last-name probe of every first-name slot" };
+		return names[path];
+	}
+};
+
+const double PROBE_COST = 4;  // A hash probe costs about as much as visiting this many people
+
+// Estimate the fraction of people whose numbers start with prefix: each digit cuts it about tenfold
+double prefixSelectivity(const string& prefix, double distinctNumbers) {
+	double sel = 1;
+	for (char c : prefix) if (isdigit((unsigned char)c)) sel /= 10;
+	return max(sel, 1 / max(distinctNumbers, 1.0));  // Never rarer than a single number
+}
+
+// Pick the cheapest access path for q. Exact bucket sizes are used where one probe finds them;
+// the distinct-count sketches stand in for everything else, assuming values are spread evenly.
+template <typename Directory>
+queryPlan planQuery(Directory& dir, const directoryStats& stats, const query& q) {
+	double n = dir.size();  // People in the directory
+	double dFirst = max(stats.firstNames.estimate(), 1.0);
+	double dLast = max(stats.lastNames.estimate(), 1.0);
+	double selFirst = q.first_name.empty() ? 1 : 1 / dFirst;
+	double selLast = q.last_name.empty() ? 1 : 1 / dLast;
+	double selPrefix = prefixSelectivity(q.numberPrefix, stats.numbers.estimate());
+
+	queryPlan best = { queryPlan::FULL_SCAN, n, n * selFirst * selLast * selPrefix };  // Always possible
+	auto consider = [&](queryPlan::accessPath path, double cost) {
+		if (cost < best.cost) best.path = path, best.cost = cost;
+	};
+
+	if (!q.first_name.empty()) {
+		auto* names = dir.find(q.first_name);  // Everyone sharing the first name's slot
+		double inSlot = names ? names->size() : 0;
+		consider(queryPlan::BY_FIRST, PROBE_COST + inSlot);
+		if (!q.last_name.empty()) {  // Both names: the nested index is already their intersection
+			auto* bucket = names ? names->find(q.last_name) : nullptr;
+			consider(queryPlan::BY_FULL_NAME, 2 * PROBE_COST + (bucket ? bucket->size() : 0));
+		}
+	}
+	else if (!q.last_name.empty()) {  // Last name alone: probe it under every first name
+		consider(queryPlan::BY_LAST, PROBE_COST * dir.slotsUsed() + n / dLast);
+	}
+	return best;
+}
+
+// Run a planned query, calling visit on each match; returns the number of matches
+template <typename Directory, typename F>
+int runQuery(Directory& dir, const queryPlan& plan, const query& q, F&& visit) {
+	int found = 0;  // Number of matches
+	auto filter = [&](const person& p) { if (q.matches(p)) { visit(p); found++; } };  // Residual predicates
+
+	switch (plan.path) {
+	case queryPlan::FULL_SCAN:
+		dir.forEach(filter);
+		break;
+	case queryPlan::BY_FIRST:
+		if (auto* names = dir.find(q.first_name)) names->forEach(filter);
+		break;
+	case queryPlan::BY_FULL_NAME:
+		if (auto* names = dir.find(q.first_name)) {
+			if (auto* bucket = names->find(q.last_name)) bucket->forEach(filter);
+		}
+		break;
+	case queryPlan::BY_LAST:
+		dir.forEachBucket([&](auto& names) {
+			if (auto* bucket = names.find(q.last_name)) bucket->forEach(filter);
+		});
+		break;
+	}
+	return found;
+}
+
+// Names the benchmarks and self-checks draw their people from
+const char* const fixtureFirstNames[] = { "Ava", "Emma", "Ethan", "Isabella", "Liam", "Lucas", "Mia", "Noah", "Olivia", "Sophia" };
+const char* const fixtureLastNames[] = { "Anderson", "Brown", "Chakrabarty", "Garcia", "Jones", "Li", "Nguyen", "Smith" };
+
+// Formats i as a distinct ddd-ddd-dddd number, in the same order as i
+string fixturePhone(int i) {
+	char buf[16];
+	snprintf(buf, sizeof buf, "%03d-%03d-%04d", 200 + i / 10000000 % 800, i / 10000 % 1000, i % 10000);
+	return string(buf);
+}
+
+// Draws a random ddd-ddd-dddd number from rng
+string fixturePhone(mt19937& rng) {
+	char buf[16];
+	snprintf(buf, sizeof buf, "%03d-%03d-%04d", 200 + (int)(rng() % 800), (int)(rng() % 1000), (int)(rng() % 10000));
+	return string(buf);
+}
+
+// The i-th number of a small self-check, 214-555-1000 onwards
+string fixtureNumber(int i) {
+	return "214-555-" + to_string(1000 + i);
+}
+
+// Records one self-check result; returns ok so callers can stop early
+bool check(const char* what, bool ok, int& failures) {
+	cout << (ok ? "ok   " : "FAIL ") << what << endl;
+	if (!ok) failures++;
+	return ok;
+}
+
+// Times a mixed load on one bucket type: readPct% lookups, the rest alternating inserts of new numbers and removals
+template <typename Bucket>
+void benchMixed(const char* name, int prefill, int ops, int readPct) {
+	mt19937 rng(42);              // Same sequence for every bucket type
+	vector<int> present;          // Ids currently in the bucket
+	Bucket bucket;
+	for (int i = 0; i < prefill; i++) {
+		bucket.insert(person("Bench", "Mark", fixturePhone(i)));
+		present.push_back(i);
+	}
+
+	int nextId = prefill;         // Next id never used before
+	long long found = 0;          // Keeps the lookups from being optimized away
+	auto start = chrono::steady_clock::now();
+	for (int i = 0; i < ops; i++) {
+		if ((int)(rng() % 100) < readPct) {
+			found += bucket.retrieve(fixturePhone(present[rng() % present.size()])).number.size();
+		}
+		else if (i % 2 || present.size() < 2) {  // Never let the bucket run empty
+			bucket.insert(person("Bench", "Mark", fixturePhone(nextId)));
+			present.push_back(nextId++);
+		}
+		else {
+			size_t at = rng() % present.size();
+			bucket.erase(person("Bench", "Mark", fixturePhone(present[at])));
+			present[at] = present.back();
+			present.pop_back();
+		}
+	}
+	double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	cout << name << " " << readPct << "% reads: " << (long long)(ops / secs) << " ops/s (" << found << ")" << endl;
+}
+
+// Directory AVL with lazy deletion on, so the benchmark can compare it with eager removal
+struct lazyAVL : AVL {
+	lazyAVL() { setLazyDelete(true); }
+};
+
+// Compares the bucket types under a few read/write mixes, for a typical small bucket and a very large one
+int runBenchmarks() {
+	for (int prefill : { 64, 100000 }) {
+		cout << "Bucket of " << prefill << ":" << endl;
+		for (int readPct : { 50, 90, 99 }) {
+			benchMixed<AVL>("AVL     ", prefill, 1000000, readPct);
+			benchMixed<lazyAVL>("AVL lazy", prefill, 1000000, readPct);
+			benchMixed<treap>("treap   ", prefill, 1000000, readPct);
+			benchMixed<skipList>("skipList", prefill, 1000000, readPct);
+			if (prefill <= 4096) benchMixed<phoneBucket>("phoneBkt", prefill, 1000000, readPct);  // Sorted-array inserts shift, so only small buckets
+		}
+	}
+	return 0;
+}
+
+// Times a disk-backed directory holding 2 to 10 times more people than its buffer pool can cache
+int runDiskBenchmark() {
+	const int FRAMES = 256;  // 1 MB memory budget
+	for (int times : { 2, 5, 10 }) {
+		bufferPool pool(FRAMES);
+		{
+			int people = times * FRAMES * LEAF_MAX * 3 / 4;  // Leaves end up about three quarters full
+			hashTable<diskBucket, byLastName> dir(8);
+			dir.setBufferPool(&pool);
+			mt19937 rng(7);
+			vector<string> numbers;  // Every number inserted, for the lookups
+			auto start = chrono::steady_clock::now();
+			for (int i = 0; i < people; i++) {
+				string n = fixturePhone(rng);
+				if (dir.insert(person("Bench", fixtureLastNames[rng() % 8], n))) numbers.push_back(n);
+			}
+			double insertSecs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+			pool.resetStats();
+			const int LOOKUPS = 100000;
+			long long found = 0;
+			start = chrono::steady_clock::now();
+			for (int i = 0; i < LOOKUPS; i++) {
+				const string& n = numbers[rng() % numbers.size()];
+				dir.forEachBucket([&](const diskBucket& b) { found += b.retrieve(n).number == n; });  // Numbers are not the hash key, so probe every bucket
+			}
+			double lookupSecs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+			double hitRate = 100.0 * pool.hits / max(pool.hits + pool.misses, 1LL);
+
+			pool.resetStats();
+			long long scanned = 0;
+			start = chrono::steady_clock::now();
+			dir.forEach([&](const person&) { scanned++; });
+			double scanSecs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+			cout << times << "x memory (" << numbers.size() << " people): " << (long long)(numbers.size() / insertSecs) << " inserts/s, "
+				<< (long long)(LOOKUPS / lookupSecs) << " lookups/s (" << found << " found, " << (int)hitRate << "% pool hits), "
+				<< (long long)(scanned / scanSecs) << " scanned/s (" << pool.disk.reads << " page reads)" << endl;
+		}
+	}
+	return 0;
+}
+
+// Times loading many people into one bucket: B+tree pages updated in place against an LSM memtable flushed in runs
+int runIngestBenchmark() {
+	const int PEOPLE = 300000;
+	const int LOOKUPS = 100000;
+	auto run = [&](const char* name, auto& bucket) {
+		mt19937 rng(11);  // Same numbers for both buckets
+		vector<string> numbers;
+		auto start = chrono::steady_clock::now();
+		for (int i = 0; i < PEOPLE; i++) {
+			string n = fixturePhone(rng);
+			if (bucket.insert(person("Bench", "Mark", n))) numbers.push_back(n);
+		}
+		double insertSecs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+		long long found = 0;
+		start = chrono::steady_clock::now();
+		for (int i = 0; i < LOOKUPS; i++) {
+			const string& n = numbers[rng() % numbers.size()];
+			found += bucket.retrieve(n).number == n;
+		}
+		double lookupSecs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+		cout << name << (long long)(numbers.size() / insertSecs) << " inserts/s, " << (long long)(LOOKUPS / lookupSecs) << " lookups/s (" << found << " found)" << endl;
+	};
+
+	bufferPool pool(256);  // Same 1 MB budget as the disk benchmark
+	{
+		diskBucket inPlace(&pool);
+		run("B+tree (in place): ", inPlace);
+		cout << "(" << pool.disk.writes << " random page writes)" << endl;
+	}
+	lsmBucket lsm;
+	run("LSM (memtable+runs): ", lsm);
+	cout << "(" << lsm.runCount() << " runs on disk)" << endl;
+	return 0;
+}
+
+// Times skewed lookups through a directory of tiered buckets: most lookups go to a few people, who stay hot
+int runTierBenchmark() {
+	const int PEOPLE = 100000;
+	const int LOOKUPS = 2000000;
+	mt19937 rng(5);
+	vector<person> people;
+	for (int i = 0; i < PEOPLE; i++) people.push_back(person(fixtureFirstNames[rng() % 10], fixtureLastNames[rng() % 8], fixturePhone(i)));
+	vector<string> sample;  // Train on a slice of the load, as a real one would
+	for (int i = 0; i < 2000; i++) {
+		const person& p = people[rng() % PEOPLE];
+		sample.insert(sample.end(), { p.first_name, p.last_name, p.number });
+	}
+	tieredBucket::trainCold(sample);
+
+	hashTable<tieredBucket, byLastName> dir(8);
+	dir.insertBatch(people);
+	auto start = chrono::steady_clock::now();
+	long long found = 0;
+	for (int i = 0; i < LOOKUPS; i++) {
+		int id = rng() % 10 ? rng() % (PEOPLE / 20) : rng() % PEOPLE;  // 90% of lookups go to the first 5% of people
+		const person& p = people[id];
+		found += dir.retrieve(p.last_name).retrieve(p.number).number == p.number;
+	}
+	double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	long long hot = 0, bytes = 0;
+	dir.forEachBucket([&](const tieredBucket& b) {
+		hot += b.hotCount();
+		bytes += b.hotBytes() + b.coldBytes();
+	});
+	long long allHot = (long long)dir.size() * sizeof(tNode);  // Memory if every person were an AVL node
+	cout << (long long)(LOOKUPS / secs) << " skewed lookups/s (" << found << " found); " << hot << " of " << dir.size() << " people hot; "
+		<< bytes << " bytes of records vs " << allHot << " all in AVL nodes" << endl;
+	return 0;
+}
+
+// Exercises paths the lab run does not reach, printing one line per check; returns the number that failed
+int runSelfChecks() {
+	int failures = 0;
+
+	{
+		phoneBucket b;  // Removing a name keeps the records before and after it intact
+		b.insert(person("Ava", "Brown", "214-555-0001"));
+		b.insert(person("Isabella", "Anderson", "214-555-0002"));
+		b.insert(person("Noah", "Smith", "214-555-0003"));
+		b.insert(person("Isabella", "Anderson", "not-a-phone"));
+		b.removeFL("Isabella", "Anderson");
+		person ava = b.retrieve("214-555-0001"), noah = b.retrieve("214-555-0003");
+		check("phoneBucket removeFL then retrieve", b.size() == 2 && ava.first_name == "Ava" && ava.last_name == "Brown" && noah.first_name == "Noah"
+			&& b.retrieve("214-555-0002").number != "214-555-0002" && b.retrieve("not-a-phone").number != "not-a-phone", failures);
+	}
+
+	{
+		timingWheel wheel;  // Expiry through the directory, then a long jump once the wheel is empty
+		hashTable<AVL, byLastName> dir(5);
+		dir.insert(person("Ava", "Brown", "214-555-0001"));
+		dir.insert(person("Noah", "Smith", "214-555-0003"));
+		wheel.schedule(person("Ava", "Brown", "214-555-0001"), 5);
+		wheel.schedule(person("Noah", "Smith", "214-555-0003"), 5000);
+		int early = dir.expire(wheel, 4), onTime = dir.expire(wheel, 5);
+		check("timingWheel expires through the directory on its tick", early == 0 && onTime == 1 && dir.size() == 1 && wheel.size() == 1, failures);
+		int late = dir.expire(wheel, 5000);
+		auto start = chrono::steady_clock::now();
+		int none = dir.expire(wheel, 2000000000);
+		double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+		check("timingWheel jumps over an empty wheel at once", late == 1 && none == 0 && dir.size() == 0 && wheel.size() == 0 && secs < 0.1, failures);
+	}
+
+	{
+		numberRegistry registry;  // Removing by name keeps the directory's count and registry in step
+		hashTable<hashTable<AVL, byLastName>, byFirstName> dir(5);
+		dir.setNumberRegistry(&registry);
+		dir.insert(person("Isabella", "Anderson", "214-555-0001"));
+		dir.insert(person("Isabella", "Anderson", "214-555-0002"));
+		dir.insert(person("Ava", "Brown", "214-555-0003"));
+		int removed = dir.removeFL("Isabella", "Anderson");
+		int left = 0;
+		dir.forEach([&](const person&) { left++; });
+		dir.insert(person("Noah", "Smith", "214-555-0001"));  // The number is free again
+		check("hashTable::removeFL keeps size and the registry current", removed == 2 && left == 1 && dir.size() == 2 && registry.reported().empty(), failures);
+	}
+
+	{
+		directoryStats seen;  // People a bucket rejects are not counted
+		hashTable<AVL, byLastName> dir(5);
+		dir.setStats(&seen);
+		dir.insert(person("Ava", "Brown", "214-555-0001"));
+		dir.insert(person("Zoe", "Brown", "214-555-0001"));  // Same number in the same bucket
+		check("stats skip rejected inserts", dir.size() == 1 && (long long)seen.firstNames.estimate() == 1, failures);
+	}
+
+	{
+		hashTable<hashTable<AVL, byLastName>, byFirstName> original(5);  // A clone shares buckets until one side writes to them
+		original.insert(person("Ava", "Brown", "214-555-0001"));
+		original.insert(person("Ava", "Brown", "214-555-0002"));
+		original.insert(person("Noah", "Smith", "214-555-0003"));
+		auto fork = original.clone();
+		fork.insert(person("Ava", "Brown", "214-555-0004"));
+		fork.erase(person("Noah", "Smith", "214-555-0003"));
+		int inOriginal = 0, inFork = 0;
+		original.forEach([&](const person&) { inOriginal++; });
+		fork.forEach([&](const person&) { inFork++; });
+		const auto* mine = original.find("Ava");  // Read-only lookups leave sharing alone
+		const auto* theirs = fork.find("Ava");
+		check("clone copies a bucket only when one side changes it", inOriginal == 3 && inFork == 3 && original.size() == 3 && fork.size() == 3
+			&& mine && theirs && mine->find("Brown")->size() == 2 && theirs->find("Brown")->size() == 3 && fork.find("Noah")->find("Smith")->size() == 0, failures);
+	}
+
+	{
+		lazyAVL b;  // Removals only mark nodes until a quarter are dead; compaction must keep exactly the live ones
+		vector<bool> present(200, false);
+		auto matches = [&]() {  // Bucket holds the present numbers, in order, and nothing else
+			vector<string> seen, expected;
+			b.forEach([&](const person& p) { seen.push_back(p.number); });
+			for (int i = 0; i < 200; i++) {
+				if (present[i]) expected.push_back(fixtureNumber(i));
+			}
+			return seen == expected && b.size() == (int)expected.size();
+		};
+		for (int i = 0; i < 200; i++) present[i] = b.insert(person("Ava", "Brown", fixtureNumber(i)));
+		for (int i = 0; i < 200; i += 3) present[i] = !b.erase(person("Ava", "Brown", fixtureNumber(i)));  // 67 removals, compacting on the way
+		present[198] = b.insert(person("Ava", "Brown", fixtureNumber(198)));  // Removed after the last compaction, so still a dead node
+		bool afterErase = matches() && b.retrieve(fixtureNumber(3)).number != fixtureNumber(3) && b.retrieve(fixtureNumber(198)).first_name == "Ava";
+		b.removeFL("Ava", "Brown");
+		fill(present.begin(), present.end(), false);
+		for (int i = 0; i < 200; i += 7) present[i] = b.insert(person("Noah", "Smith", fixtureNumber(i)));
+		b.setLazyDelete(false);  // Leaving lazy mode compacts whatever is dead
+		check("lazy deletion and compaction keep exactly the live people", afterErase && matches(), failures);
+	}
+	{
+		hashTable<hashTable<AVL, byLastName>, byFirstName> dir(2);  // Lazy deletion is a table setting, so it must outlive resizes
+		dir.setLazyDelete(true);
+		for (int i = 0; i < 200; i++) dir.insert(person(fixtureFirstNames[i % 10], fixtureLastNames[i % 8] + to_string(i), fixtureNumber(i)));
+		int lazyBuckets = 0, buckets = 0;
+		dir.forEachBucket([&](const hashTable<AVL, byLastName>& names) {
+			names.forEachBucket([&](const AVL& b) {
+				buckets++;
+				lazyBuckets += b.lazyDelete();
+			});
+		});
+		bool grew = dir.size() == 200 && buckets > 10;  // Ten first names outgrow the two-slot table
+		dir.setLazyDelete(false);
+		int stillLazy = 0;
+		dir.forEachBucket([&](const hashTable<AVL, byLastName>& names) { names.forEachBucket([&](const AVL& b) { stillLazy += b.lazyDelete(); }); });
+		check("lazy deletion survives resizes until switched off", grew && lazyBuckets == buckets && stillLazy == 0, failures);
+	}
+
+	{
+		vector<person> batch;  // A batch loads the same people as one insert each
+		for (int i = 0; i < 400; i++) batch.push_back(person("Ava", fixtureLastNames[i % 8] + to_string(i % 50), fixtureNumber(i)));
+		batch.push_back(batch[0]);  // A repeat the bucket rejects
+		hashTable<AVL, byLastName> one(5), all(5);
+		int added = 0;
+		for (const person& p : batch) added += one.insert(p);
+		int batched = all.insertBatch(batch);
+		vector<string> a, b;
+		one.forEach([&](const person& p) { a.push_back(p.number); });
+		all.forEach([&](const person& p) { b.push_back(p.number); });
+		sort(a.begin(), a.end());
+		sort(b.begin(), b.end());
+		check("insertBatch matches one insert per person", added == 400 && batched == 400 && all.size() == 400 && a == b, failures);
+
+		vector<person> probes;  // Every other person, then people who were never added
+		for (int i = 0; i < 400; i += 2) probes.push_back(batch[i]);
+		for (int i = 0; i < 20; i++) probes.push_back(person("Ava", fixtureLastNames[i % 8] + to_string(i), fixtureNumber(400 + i)));
+		vector<person> got = all.retrieveBatch(probes);
+		bool matched = got.size() == probes.size();
+		for (size_t i = 0; matched && i < probes.size(); i++) matched = (got[i].number == probes[i].number) == (i < 200) && (i >= 200 || got[i].last_name == probes[i].last_name);
+		check("retrieveBatch answers each probe in order", matched, failures);
+	}
+
+	{
+		skipList b;  // Removed nodes are freed while the list stays busy, alone or shared by several threads
+		int mostRetired = 0;        // Largest backlog of retired nodes seen
+		for (int round = 0; round < 1000; round++) {
+			b.insert(person("Ava", "Brown", fixtureNumber(round % 50)));
+			b.erase(person("Ava", "Brown", fixtureNumber((round + 25) % 50)));
+			mostRetired = max(mostRetired, b.retiredCount());
+		}
+		atomic<int> mostShared(0);  // Same, with four threads that never let the list go idle
+		vector<thread> workers;
+		for (int t = 0; t < 4; t++) {
+			workers.emplace_back([&b, &mostShared, t] {
+				for (int round = 0; round < 20000; round++) {
+					b.insert(person("Ava", "Brown", fixtureNumber(100 + t * 100 + round % 100)));
+					b.erase(person("Ava", "Brown", fixtureNumber(100 + t * 100 + (round + 50) % 100)));
+					b.retrieve(fixtureNumber(round % 500));
+					int seen = b.retiredCount(), most = mostShared.load();
+					while (seen > most && !mostShared.compare_exchange_weak(most, seen)) {}
+					if (round % 16 == 0) this_thread::yield();  // Hand over between operations, so on few cores no thread stalls inside one
+				}
+			});
+		}
+		for (thread& w : workers) w.join();
+		b.reclaim();
+		int live = 0;
+		b.forEach([&](const person&) { live++; });
+		bool counted = live == b.size() && live == 25 + 4 * 50 && b.retiredCount() == 0;
+		skipList moved(std::move(b));
+		moved.insert(person("Noah", "Brown", fixtureNumber(999)));
+		skipList assigned;
+		assigned = std::move(moved);
+		check("skipList keeps a bounded backlog of removed nodes under constant load", mostRetired < 200 && mostShared.load() < 1000
+			&& counted && assigned.size() == live + 1, failures);
+	}
+	{
+		lsmBucket::setMemtableLimit(4);  // Removals are flagged beside the person, so no first name can pass for one
+		lsmBucket b;
+		for (int i = 0; i < 40; i++) b.insert(person("\x7f", "Brown", fixtureNumber(i)));
+		for (int i = 0; i < 40; i += 4) b.erase(person("\x7f", "Brown", fixtureNumber(i)));
+		b.flush();
+		int live = 0;
+		b.forEach([&](const person& p) { live += p.first_name == "\x7f"; });
+		bool found = true;
+		for (int i = 0; i < 40; i++) found = found && (b.retrieve(fixtureNumber(i)).number == fixtureNumber(i)) == (i % 4 != 0);
+		lsmBucket::setMemtableLimit(4096);
+		check("lsmBucket keeps people whatever their first name", live == 30 && b.size() == 30 && found, failures);
+	}
+	{
+		bufferPool poolA(16), poolB(16);  // Two directories, each paging through its own pool only
+		hashTable<diskBucket, byLastName> a(4), b(4);
+		a.setBufferPool(&poolA);
+		b.setBufferPool(&poolB);
+		for (int i = 0; i < 300; i++) a.insert(person("Ava", i % 2 ? "Brown" : "Garcia", fixtureNumber(i)));
+		bool bUntouched = poolB.hits + poolB.misses == 0 && poolB.disk.writes == 0;
+		a.resize(40);  // Rebuilt buckets stay in a's pool
+		b.insert(person("Noah", "Brown", "214-555-2000"));
+		long long aPins = poolA.hits + poolA.misses;
+		int inA = 0;
+		a.forEach([&](const person&) { inA++; });
+		check("diskBucket directories keep to their own buffer pools", bUntouched && poolA.hits + poolA.misses > aPins && poolB.hits + poolB.misses > 0
+			&& inA == 300 && b.size() == 1, failures);
+	}
+	{
+		tieredBucket b;  // A retier pass sends idle people cold and brings looked-up ones back, losing nobody
+		vector<string> sample;
+		for (int i = 0; i < 200; i++) sample.push_back(fixtureNumber(i));
+		tieredBucket::trainCold(sample);
+		for (int i = 0; i < 200; i++) b.insert(person("Ava", "Brown", fixtureNumber(i)));
+		b.retier();  // Every counter halves from 1 to 0
+		b.retier();  // So now everybody goes cold
+		bool allCold = b.hotCount() == 0;
+		for (int round = 0; round < 8; round++) {
+			for (int i = 0; i < 10; i++) b.retrieve(fixtureNumber(i));
+		}
+		b.retier();
+		bool warmed = b.hotCount() > 0 && b.hotCount() <= 10;
+		b.erase(person("Ava", "Brown", fixtureNumber(3)));
+		b.erase(person("Ava", "Brown", fixtureNumber(150)));
+		bool all = b.size() == 198;
+		for (int i = 0; i < 200; i++) all = all && (b.retrieve(fixtureNumber(i)).number == fixtureNumber(i)) == (i != 3 && i != 150);
+		vector<string> seen;
+		b.forEach([&](const person& p) { seen.push_back(p.number); });
+		sort(seen.begin(), seen.end());
+		seen.erase(unique(seen.begin(), seen.end()), seen.end());
+		check("tieredBucket moves people between tiers without losing any", allCold && warmed && all && seen.size() == 198, failures);
+	}
+	{
+		hashTable<hashTable<AVL, byLastName>, byFirstName> dir(5);  // Cursor text comes back from clients, so it may be anything
+		for (int i = 0; i < 20; i++) dir.insert(person("Ava", "Brown" + to_string(i % 4), fixtureNumber(i)));
+		bool rejected = true;
+		for (const char* text : { "x/1/214", "-1/2/", "99999999999/0/", "3//214", "1/2a/" }) {
+			scanCursor c = scanCursor::decode(text);
+			rejected = rejected && !c.valid && dir.page(c, 5, [](const person&) {}) == 0;
+		}
+		scanCursor forged;
+		forged.slot = { -1, -7 };  // Built by hand, not by decode
+		int forgedVisits = dir.page(forged, 5, [](const person&) {});
+		scanCursor c;
+		int total = dir.page(c, 7, [](const person&) {});
+		c = scanCursor::decode(c.encode());
+		while (c.valid && !c.done) total += dir.page(c, 7, [](const person&) {});
+		check("malformed cursors page nothing and a decoded one resumes", rejected && forgedVisits == 0 && forged.done && total == 20, failures);
+	}
+	{
+		vector<string> names;  // Enough names for several blocks, with a gap before, between and after them
+		for (int i = 0; i < 50; i++) names.push_back(string(fixtureLastNames[i % 8]) + ", " + to_string(10 + i));
+		frontCodedNames store(names);
+		sort(names.begin(), names.end());
+		bool found = store.size() == 50;
+		for (int i = 0; i < 50; i++) found = found && store.find(names[i]) == i && store.find(names[i] + "!") == -1;
+		string first, between, last;
+		bool bounds = store.lowerBound("A", &first) == 0 && first == names[0] && store.find("A") == -1
+			&& store.lowerBound(names[15] + "!", &between) == 16 && between == names[16]
+			&& store.lowerBound("Zz", &last) == 50 && last.empty() && store.find("Zz") == -1;
+		check("frontCodedNames finds exactly the names it holds", found && bounds, failures);
+	}
+
+	cout << failures << " failed" << endl;
+	return failures;
+}
+
+int main(int argc, char* argv[]) {  // Entry point of the program
+	if (argc > 1 && string(argv[1]) == "--bench") return runBenchmarks();  // Compare bucket types instead of running the lab
+	if (argc > 1 && string(argv[1]) == "--bench-disk") return runDiskBenchmark();  // Time the out-of-core directory instead
+	if (argc > 1 && string(argv[1]) == "--bench-ingest") return runIngestBenchmark();  // Time bulk loading into disk-backed buckets instead
+	if (argc > 1 && string(argv[1]) == "--bench-tiers") return runTierBenchmark();  // Time hot/cold tiered buckets instead
+	if (argc > 1 && string(argv[1]) == "--check") return runSelfChecks() ? 1 : 0;  // Run the self-checks instead
+
+	ifstream file("Lab3_Problem2_DSC++.csv");  // Open the CSV file for reading
+
+	// Check if the file is open
+	if (!file.is_open()) {  // Check if the file failed to open
+		cerr << "Error: Could not open the file!" << std::endl;  // Output error message to standard error
+		return 1;  // Exit the program with an error code
+	}
+
+	hashTable<hashTable<AVL, byLastName>, byFirstName> table(11);  // Create a hash table with a size of 11, keyed by first then last name
+	string first_name;  // Variable to store the first name
+	string last_name;  // Variable to store the last name
+	string number;  // Variable to store the number
+	heavyHitters firstStats, lastStats, areaStats;  // Most common first names, last names and area codes in this load
+	directoryStats distinct;  // Distinct-count sketches for capacity planning
+	table.setStats(&distinct);  // Have the directory keep them up to date on insert
+	numberRegistry registry;  // Numbers already handed out, to catch one given to two people
+	table.setNumberRegistry(&registry);
+
+	// Read each line from the file
+	while (file.peek() != EOF) {  // Continue until the end of the file is reached
+		file.ignore(numeric_limits<streamsize>::max(), '\'');  // Ignore characters until the first single quote
+		if (!(file >> first_name)) break;  // Read the first name, break if reading fails
+
+		file.ignore(numeric_limits<streamsize>::max(), ' ');  // Ignore the space after the first name
+		if (!getline(file, last_name, '\'')) break;  // Read the last name until the next single quote, break if reading fails
+
+		file.ignore(numeric_limits<streamsize>::max(), '\'');  // Ignore characters until the next single quote
+		if (!getline(file, number, '\'')) break;  // Read the number until the next single quote, break if reading fails
+
+		firstStats.add(first_name);  // Count the fields as they stream past
+		lastStats.add(last_name);
+		areaStats.add(number.substr(0, 3));
+
+		table.insert(person(first_name, last_name, number));  // Insert the person into the hash table
+	}
+
+	file.close();  // Close the file after reading
+
+	table.printAll();  // Print all entries in the hash table
+
+	cout << endl << endl << "PRINTING ALL \"Liam\"s:" << endl;  // Output message for printing all "Liam" entries
+	table.retrieve("Liam").printFN("Liam");  // Print all entries with first name "Liam"
+	cout << endl << endl;  // Print two new lines for spacing
+
+	cout << "REMOVING ALL \"Isabella Anderson\"s:" << endl;  // Output message for removing all "Isabella Anderson" entries
+	table.removeFL("Isabella", "Anderson");  // Remove all entries with name "Isabella Anderson"
+	table.printAll();  // Print all entries in the hash table again
+	cout << endl << endl;  // Print two new lines for spacing
+
+	cout << "PRINTING ALL \"Shaibal Chakrabarty\"s:" << endl;  // Output message for printing all "Shaibal Chakrabarty" entries
 	table.retrieve("Shaibal").retrieve("Chakrabarty").printFN("Shaibal");  // Print all entries with first name "Shaibal"
 
 	cout << "PRINTING ALL \"Lucas Li\"s:" << endl;  // Output message for printing all "Lucas Li" entries
@@ -487,12 +4786,61 @@ int main() {  // Entry point of the program
 	cout << endl << endl;  // Print two new lines for spacing
 
 	cout << "INSERTING \"Lucas Li\" and \"Shaibal Chakrabarty\":" << endl;  // Output message for inserting new entries
-	temp = person("Shaibal", "Chakrabarty", "214-768-2000");  // Create a new person object for Shaibal
-	table.retrieve(temp.first_name).retrieve(temp.last_name).insert(temp);  // Insert Shaibal into the hash table
-	temp = person("Lucas", "Li", "469-555-1212");  // Create a new person object for Lucas
-	table.retrieve(temp.first_name).retrieve(temp.last_name).insert(temp);  // Insert Lucas into the hash table
+	table.insert(person("Shaibal", "Chakrabarty", "214-768-2000"));  // Insert Shaibal into the hash table
+	table.insert(person("Lucas", "Li", "469-555-1212"));  // Insert Lucas into the hash table
 
 	table.printAll();  // Print all entries in the hash table again
+	cout << endl << endl;  // Print two new lines for spacing
+
+	cout << "MOST COMMON IN THIS LOAD:" << endl;  // Output the statistics gathered while loading
+	for (const pair<const char*, heavyHitters*>& field : { make_pair("First names", &firstStats), make_pair("Last names", &lastStats), make_pair("Area codes", &areaStats) }) {
+		cout << field.first << ": ";  // Label the field
+		for (const pair<string, int>& entry : field.second->top(3)) cout << entry.first << " (~" << entry.second << ") ";  // Print each top key with its estimated count
+		cout << endl;
+	}
+	cout << "Distinct first names: ~" << (long long)distinct.firstNames.estimate() << ", last names: ~" << (long long)distinct.lastNames.estimate() << ", numbers: ~" << (long long)distinct.numbers.estimate() << endl;  // Output the distinct-count estimates
+	cout << endl;
+
+	vector<string> fullNames;  // "Last, First" for everyone, so names sort by family
+	table.forEach([&](const person& p) { fullNames.push_back(p.last_name + ", " + p.first_name); });
+	frontCodedNames nameStore(fullNames);
+	size_t asStrings = sizeof(vector<string>) + nameStore.size() * sizeof(string);  // The same names as separate strings
+	nameStore.forEach([&](int, const string& n) { if (n.size() >= sizeof(string) / 2) asStrings += n.size() + 1; });  // Short ones fit in the string itself
+	cout << "NAME STORE: " << nameStore.size() << " distinct names in " << nameStore.memoryUsed() << " bytes front coded vs " << asStrings << " as strings; ";
+	cout << "first \"Li, \" is " << nameStore.at(nameStore.lowerBound("Li, ")) << endl << endl;
+
+	vector<person> everyone;  // Sample to train on, then the people to store
+	table.forEach([&](const person& p) { everyone.push_back(p); });
+	compressedPeople packed(everyone);
+	for (const person& p : everyone) packed.add(p);
+	int shaibal = packed.findNumber("214-768-2000");  // Matched on compressed bytes
+	cout << "COMPRESSED PEOPLE: " << packed.size() << " people in " << packed.memoryUsed() << " bytes with " << packed.symbols().symbols() << " symbols vs "
+		<< everyone.size() * sizeof(person) << " as person structs; 214-768-2000 is " << (shaibal < 0 ? string("nobody") : packed.field(shaibal, compressedPeople::FIRST)) << endl << endl;
+
+	cout << "NUMBERS SHARED BY DIFFERENT PEOPLE:" << endl;  // Output the full join's findings and what the registry caught on insert
+	for (const vector<person>& group : findSharedNumbers(table)) {
+		cout << group[0].number << ": ";
+		for (const person& p : group) cout << p.first_name << ' ' << p.last_name << " || ";
+		cout << endl;
+	}
+	cout << "(" << registry.reported().size() << " caught on insert)" << endl << endl;
+
+	cout << "FIRST TWO PAGES OF 5:" << endl;  // Output the directory a page at a time, resuming from a saved position
+	scanCursor cursor;
+	table.page(cursor, 5, [](const person& p) { cout << p.first_name << ' ' << p.last_name << " : " << p.number << " || "; });
+	string saved = cursor.encode();  // What a front-end would hand back for the next page
+	cout << endl << "(resume at " << saved << ")" << endl;
+	cursor = scanCursor::decode(saved);
+	table.page(cursor, 5, [](const person& p) { cout << p.first_name << ' ' << p.last_name << " : " << p.number << " || "; });
+	cout << endl << endl;
+
+	cout << "QUERIES:" << endl;  // Output a few planned queries
+	for (const query& q : { query{ "Lucas", "Li", "" }, query{ "", "Anderson", "469" }, query{ "", "", "214-7" } }) {
+		queryPlan plan = planQuery(table, distinct, q);  // Choose how to answer it
+		cout << "first='" << q.first_name << "' last='" << q.last_name << "' number='" << q.numberPrefix << "*' via " << plan.name() << " (est. cost " << (long long)plan.cost << "): ";
+		int found = runQuery(table, plan, q, [](const person& p) { cout << p.first_name << ' ' << p.last_name << " : " << p.number << " || "; });
+		cout << "[" << found << " found]" << endl;
+	}
 
 	return 0;  // Exit the program successfully
 }